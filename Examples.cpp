@@ -1,5 +1,7 @@
+#define TISS_REGISTRY 1
 #include "tiss.h"
 #include <stdio.h>
+#include <assert.h>
 
 
 struct Com {
@@ -216,6 +218,391 @@ void example_safe_forward2()
 	s(Object());
 }
 
+void example_topic_bus()
+{
+	printf("example_topic_bus\n");
+	tiss::topic_bus<void(int)> bus;
+
+	bus.subscribe("orders.*.filled", [](int qty) {
+		printf("orders.*.filled %d\n", qty);
+	});
+	bus.subscribe("orders.#", [](int qty) {
+		printf("orders.# %d\n", qty);
+	});
+	bus.subscribe("md.#", [](int qty) {
+		printf("md.# %d\n", qty);
+	});
+
+	bus.publish("orders.eu.filled", 10);
+	bus.publish("orders.eu.cancelled", 20);
+
+	// resolve once, then publish by id
+	auto id = bus.intern("md.eu.quote");
+	bus.publish(id, 30);
+}
+
+void example_queued_connection()
+{
+	printf("example_queued_connection\n");
+	tiss::thread_context ctx;
+	tiss::signal<void(int)> s;
+
+	// the slot runs on the thread calling ctx.pump()
+	s.connect([](int x) {
+		printf("queued slot %d\n", x);
+	}, ctx);
+
+	// at most 4 pending messages, older ones are dropped in favor of newer ones
+	tiss::queue_options opts;
+	opts.capacity = 4;
+	opts.policy = tiss::queue_policy::coalesce;
+	s.connect([](int x) {
+		printf("coalesced slot %d\n", x);
+	}, ctx, opts);
+
+	std::thread producer([&]() {
+		for (int i = 0; i < 6; ++i) s(i);
+	});
+	producer.join();
+
+	ctx.pump();
+}
+
+void example_emit_budgeted()
+{
+	printf("example_emit_budgeted\n");
+	tiss::signal<void(int)> s;
+	for (int i = 0; i < 5; ++i) {
+		s.connect([i](int x) {
+			printf("slot %d got %d\n", i, x);
+		});
+	}
+
+	// a deadline in the past: one slot per tick
+	auto deadline = std::chrono::steady_clock::now();
+	auto cursor = s.emit_budgeted(deadline, 42);
+	int ticks = 1;
+	while (!s.resume(cursor, deadline)) {
+		++ticks;
+	}
+	printf("finished in %d ticks\n", ticks + 1);
+}
+
+void example_connect_pure()
+{
+	printf("example_connect_pure\n");
+	tiss::signal<int(int, int)> s;
+	tiss::memo_stats stats;
+
+	s.connect_pure([](int bid, int ask) {
+		printf("recalculate mid\n");
+		return (bid + ask) / 2;
+	}, &stats);
+
+	for (int i = 0; i < 3; ++i) {
+		for (auto mid : s.emit_and_get_range(100, 102)) {
+			printf("mid %d\n", mid);
+		}
+	}
+	printf("hits %d misses %d\n", (int)stats.hits, (int)stats.misses);
+}
+
+void example_keyed_signal()
+{
+	printf("example_keyed_signal\n");
+	// the key is the first argument by default
+	tiss::keyed_signal<int, void(int, double)> s;
+
+	s.connect(1, [](int id, double px) {
+		printf("instrument 1: %d %g\n", id, px);
+	});
+	s.connect(2, [](int id, double px) {
+		printf("instrument 2: %d %g\n", id, px);
+	});
+	s.connect_all([](int id, double px) {
+		printf("catch-all: %d %g\n", id, px);
+	});
+
+	s(1, 10.5);
+	s(3, 11.5);
+}
+
+void example_pipeline()
+{
+	printf("example_pipeline\n");
+	tiss::signal<void(int)> s;
+
+	// one slot, the stages are fused into it
+	s | tiss::filter([](int x) { return x % 2 == 0; })
+	  | tiss::map([](int x) { return x * 10; })
+	  | tiss::take(2)
+	  | tiss::connect([](int y) {
+		printf("sink %d\n", y);
+	});
+
+	for (int i = 0; i < 10; ++i) s(i);
+}
+
+void example_connect_many()
+{
+	printf("example_connect_many\n");
+	tiss::signal<void(int)> s;
+
+	struct Printer {
+		int id;
+		void operator()(int x) { printf("printer %d got %d\n", id, x); }
+	};
+	std::vector<Printer> printers = { { 0 }, { 1 }, { 2 }, { 3 } };
+	std::vector<tiss::connection> cons;
+
+	// one allocation, one splice
+	s.connect_many(printers, std::back_inserter(cons));
+	printf("num of connections %d\n", (int)s.num_connections());
+
+	// disconnect the odd printers in one walk
+	auto odd = [&](tiss::connection_body<void, int> const &body) {
+		return &body == cons[1].body() || &body == cons[3].body();
+	};
+	s.disconnect_if(odd);
+	printf("num of connections %d\n", (int)s.num_connections());
+	s(7);
+}
+
+void example_slot_handle()
+{
+	printf("example_slot_handle\n");
+	tiss::signal<void(int)> s;
+
+	// plain {index, generation}, copying it is free
+	std::vector<tiss::slot_handle> handles;
+	for (int i = 0; i < 3; ++i) {
+		handles.push_back(s.connect_slot([i](int x) {
+			printf("slot %d got %d\n", i, x);
+		}));
+	}
+
+	// the body is freed here, no handle keeps it
+	s.disconnect(handles[1]);
+	printf("the second slot status %d\n", s.connected(handles[1]));
+	s(1);
+}
+
+void example_throttle_debounce()
+{
+	printf("example_throttle_debounce\n");
+	tiss::signal<void(int)> s;
+	tiss::timer_wheel wheel(std::chrono::milliseconds(1));
+
+	// emission only keeps the latest value, the slots run from wheel.tick()
+	s.connect_throttled([](int x) {
+		printf("throttled %d\n", x);
+	}, std::chrono::milliseconds(10), wheel);
+	s.connect_debounced([](int x) {
+		printf("debounced %d\n", x);
+	}, std::chrono::milliseconds(5), wheel);
+
+	// 30 ticks of input, then quiet
+	for (int i = 0; i < 30; ++i) {
+		s(i);
+		wheel.advance(1);
+	}
+	wheel.advance(10);
+}
+
+void example_connect_signal()
+{
+	printf("example_connect_signal\n");
+	tiss::signal<void(int)> component;
+	tiss::signal<void(int)> aggregate;
+
+	aggregate.connect([](int x) {
+		printf("aggregate got %d\n", x);
+	});
+
+	// component's emission walks the slots of aggregate directly
+	component.connect_signal(aggregate);
+	component(1);
+}
+
+struct Ticker {
+	int id;
+	void on_tick(int t) { printf("ticker %d tick %d\n", id, t); }
+};
+
+void example_member_multicast()
+{
+	printf("example_member_multicast\n");
+	tiss::signal<void(int)> s;
+	std::vector<Ticker> tickers = { { 0 }, { 1 }, { 2 } };
+
+	// one slot, Ticker::on_tick is called directly for every object
+	tiss::member_multicast<decltype(&Ticker::on_tick), &Ticker::on_tick> mc;
+	std::vector<tiss::slot_handle> handles;
+	for (auto &t : tickers) handles.push_back(mc.add(&t));
+	s.connect_multicast(mc);
+
+	s(1);
+	// O(1), the last ticker takes the place of the first one
+	mc.remove(handles[0]);
+	s(2);
+}
+
+void example_property()
+{
+	printf("example_property\n");
+	tiss::property<int> width(2), height(3);
+	tiss::computed<int> area(width, height, [](int w, int h) { return w * h; });
+	tiss::computed<bool> large(area, [](int a) { return a > 10; });
+	area.changed.connect([](int a) { printf("area %d\n", a); });
+	large.changed.connect([](bool l) { printf("large %d\n", (int)l); });
+
+	width.set(4);
+	{
+		// one notification, when the transaction ends
+		tiss::transaction tx;
+		width.set(6);
+		height.set(1);
+	}
+	// area stays 6, nobody is notified
+	{
+		tiss::transaction tx;
+		width.set(3);
+		height.set(2);
+	}
+}
+
+struct Dictionary {
+	std::vector<std::string> fWords;
+	Dictionary(std::string const &path) {
+		// expensive, think of loading a file
+		printf("load %s\n", path.c_str());
+		fWords = { "apple", "banana" };
+	}
+	void operator()(int i) { printf("word %s\n", fWords[i % fWords.size()].c_str()); }
+};
+
+void example_connect_lazy()
+{
+	printf("example_connect_lazy\n");
+	tiss::signal<void(int)> s;
+	// only the path is stored, nothing is loaded yet
+	s.connect_lazy<Dictionary>("en.txt");
+	s.connect_lazy<Dictionary>("fr.txt");
+	// load everything now, instead of on the first emission
+	printf("built %d\n", (int)s.materialize_all());
+	s(1);
+}
+
+void example_inline_signal()
+{
+	printf("example_inline_signal\n");
+	// room for 2 slots in the signal itself, nothing is allocated
+	tiss::inline_signal<void(int), 2> s;
+	auto a = s.connect([](int i) { printf("a %d\n", i); });
+	auto b = s.connect([](int i) { printf("b %d\n", i); });
+	// full
+	auto c = s.connect([](int i) { printf("c %d\n", i); });
+	printf("c connected %d\n", (int)c.connected());
+	s(1);
+	// the slot of a is free again
+	a.disconnect();
+	c = s.connect([](int i) { printf("c %d\n", i); });
+	s(2);
+}
+
+struct Quote {
+	int seq;
+	double price;
+};
+
+struct Position {
+	int seq;
+	int quantity;
+};
+
+void example_join()
+{
+	printf("example_join\n");
+	tiss::signal<void(Quote const &)> quote;
+	tiss::signal<void(Position const &)> position;
+	tiss::join_stats stats;
+	// runs once both have emitted for a sequence number
+	auto j = tiss::join(quote, position, [](auto const &m) { return m.seq; })
+		.connect([](Quote const &q, Position const &p) {
+			printf("seq %d value %g\n", q.seq, q.price * p.quantity);
+		}, &stats);
+
+	quote(Quote{ 1, 10.0 });
+	quote(Quote{ 2, 11.0 });
+	position(Position{ 2, 3 });
+	position(Position{ 1, 5 });
+	printf("completed %d evicted %d\n", (int)stats.completed, (int)stats.evicted);
+}
+
+struct Click {
+	int x;
+	int y;
+};
+
+void example_propagation_tree()
+{
+	printf("example_propagation_tree\n");
+	tiss::propagation_tree<Click> tree;
+	auto window = tree.add();
+	auto dialog = tree.add(window);
+	auto button = tree.add(dialog);
+
+	tree.capture(window).connect([](Click &c) { printf("window capture %d %d\n", c.x, c.y); return true; });
+	tree.bubble(button).connect([](Click &) { printf("button clicked\n"); return true; });
+	// the dialog eats the clicks, the window never sees them bubble
+	tree.bubble(dialog).connect([](Click &) { printf("dialog stops\n"); return false; });
+	tree.bubble(window).connect([](Click &) { printf("window bubble\n"); return true; });
+
+	Click click{ 1, 2 };
+	tree.dispatch(button, click);
+	// the button moves to the window, its path is rebuilt by the next dispatch
+	tree.reparent(button, window);
+	tree.dispatch(button, click);
+}
+
+void example_registry()
+{
+	printf("example_registry\n");
+	tiss::signal<void(int)> s;
+	s.set_name("prices");
+	auto kept = s.connect([](int) { });
+	s.connect([](int) { });
+	s(1);
+	// an emission relayed by connect_signal counts as one of s
+	tiss::signal<void(int)> relay;
+	relay.connect_signal(s);
+	relay(2);
+
+	// disconnected through a copy, kept still points at the slot and pins its memory
+	tiss::connection(kept).disconnect();
+	for (auto &info : tiss::registry_snapshot()) {
+		if (info.name != "prices") continue;
+		printf("%s %s: %zu live, %zu pinned (%zu bytes), %zu emissions\n", info.name.c_str(),
+			info.signature.c_str(), info.live_slots, info.pinned_slots, info.pinned_bytes, info.emissions);
+		assert(info.alive && info.live_slots == 1 && info.pinned_slots == 1 && info.emissions == 2);
+		assert(info.pinned_bytes > 0);
+	}
+	std::string json = tiss::registry_dump_json();
+	auto at = json.find("{\"name\":\"prices\"");
+	assert(at != std::string::npos);
+	std::string entry = json.substr(at, json.find('}', at) - at + 1);
+	printf("%s\n", entry.c_str());
+	assert(entry.find("\"live_slots\":1,") != std::string::npos);
+	assert(entry.find("\"pinned_slots\":1,") != std::string::npos);
+	assert(entry.find("\"emissions\":2}") != std::string::npos);
+
+	// dropping the handle frees it
+	kept = tiss::connection();
+	for (auto &info : tiss::registry_snapshot()) {
+		if (info.name == "prices") assert(info.pinned_slots == 0 && info.pinned_bytes == 0);
+	}
+}
+
 int main() {
 	example_connect();
 	example_disconnect();
@@ -223,6 +610,23 @@ int main() {
 	example_emit_util_false();
 	example_safe_forward();
 	example_safe_forward2();
+	example_topic_bus();
+	example_queued_connection();
+	example_emit_budgeted();
+	example_connect_pure();
+	example_keyed_signal();
+	example_pipeline();
+	example_connect_many();
+	example_slot_handle();
+	example_throttle_debounce();
+	example_connect_signal();
+	example_member_multicast();
+	example_property();
+	example_connect_lazy();
+	example_inline_signal();
+	example_join();
+	example_propagation_tree();
+	example_registry();
 	static_assert(std::is_same<tiss::details::copy_forward_type<int&>, int &>::value, "");
 	static_assert(std::is_same<tiss::details::copy_forward_type<int>, int const &>::value, "");
 	static_assert(std::is_same<tiss::details::copy_forward_type<int &&>, int &&>::value, "");
@@ -1,6 +1,13 @@
 #include <boost/signals2.hpp>
 #include <chrono>
 #include <iostream>
+#include <cassert>
+// test_no_alloc_emit and test_inline_signal_alloc run when built with -DTISS_ALLOC_ACCOUNTING=1 (and -DTISS_DEFINE_ALLOC_HOOKS to count every allocation)
+// the accounting is off by default, it would weigh on the timings
+#if defined(__linux__)
+#define TISS_JOURNAL 1
+#define TISS_IPC 1
+#endif
 #include "tiss.h"
 
 // baseline
@@ -135,7 +142,7 @@ void test_invoke2()
 		for (int i = 0; i < 10000000; ++i) {
 			int a;
 			auto rng = signal.emit_and_get_range(i, a);
-			tiss::_Get_Tuple<void(int, int&)>::type;
+			static_assert(std::tuple_size<tiss::_Get_Tuple<void(int, int&)>::type>::value == 2, "");
 			auto b = rng.begin();
 			auto e = rng.end();
 			for (; b != e; ++b) {
@@ -241,7 +248,7 @@ void test_invoke10()
 		for (int i = 0; i < 10000000; ++i) {
 			int a;
 			auto rng = signal.emit_and_get_range(i, a);
-			tiss::_Get_Tuple<void(int, int&)>::type;
+			static_assert(std::tuple_size<tiss::_Get_Tuple<void(int, int&)>::type>::value == 2, "");
 			auto b = rng.begin();
 			auto e = rng.end();
 			for (; b != e; ++b) {
@@ -410,6 +417,1161 @@ void test_heavy_lambda_connect()
 
 }
 
+void test_keyed_invoke()
+{
+
+	printf("test_keyed_invoke\n");
+	namespace cr = std::chrono;
+
+	int const N = 50000;
+	{
+		printf("tiss.signal, filter in slot\n");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		for (int k = 0; k < N; ++k) {
+			signal.connect([k](int i, int &a) { if (i == k) foo(i, a); });
+		}
+		auto sum = 0;
+		for (int i = 0; i < 1000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.keyed_signal\n");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::keyed_signal<int, void(int, int&)> signal;
+		for (int k = 0; k < N; ++k) {
+			signal.connect(k, foo);
+		}
+		auto sum = 0;
+		for (int i = 0; i < 1000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+void test_pipeline_invoke()
+{
+
+	printf("test_pipeline_invoke\n");
+	namespace cr = std::chrono;
+
+	{
+		printf("tiss.signal chained by re-emission\n");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> s0, s1, s2, s3, s4;
+		s0.connect([&](int i, int &a) { if (i >= 0) s1(i, a); });
+		s1.connect([&](int i, int &a) { s2(i + 1, a); });
+		s2.connect([&](int i, int &a) { if (i != -1) s3(i, a); });
+		s3.connect([&](int i, int &a) { s4(i - 1, a); });
+		s4.connect(foo);
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			s0(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal fused pipeline\n");
+		auto t0 = cr::high_resolution_clock::now();
+
+		struct arg { int i; int *a; };
+		tiss::signal<void(int, int&)> s0;
+		s0 | tiss::filter([](int i, int &) { return i >= 0; })
+		   | tiss::map([](int i, int &a) { return arg{ i + 1, &a }; })
+		   | tiss::filter([](arg r) { return r.i != -1; })
+		   | tiss::map([](arg r) { return arg{ r.i - 1, r.a }; })
+		   | tiss::connect([](arg r) { foo(r.i, *r.a); });
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			s0(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+void test_connect_many()
+{
+
+	printf("test_connect_many\n");
+
+	namespace cr = std::chrono;
+
+	auto stub = [](int i, int &a) { foo(i, a); };
+	std::vector<decltype(stub)> slots(1000, stub);
+	{
+		printf("tiss.signal connect in a loop\n");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		for (int i = 0; i < 10000; ++i) {
+			for (auto &f : slots) signal.connect(f);
+			signal.disconnect_all();
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal.connect_many\n");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		for (int i = 0; i < 10000; ++i) {
+			signal.connect_many(slots);
+			signal.disconnect_all();
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+#if defined(__linux__)
+void test_journal()
+{
+
+	printf("test_journal\n");
+
+	namespace cr = std::chrono;
+
+	{
+		printf("tiss.signal recorded by a journal: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect(foo);
+		tiss::journal journal("tiss_journal.bin", 64 << 20);
+		journal.record(signal, 1);
+		auto sum = 0;
+		for (int i = 0; i < 1000000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		// the recorded load, instead of a synthetic loop
+		printf("tiss.journal_reader.replay: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect(foo);
+		tiss::journal_reader reader("tiss_journal.bin");
+		reader.bind(1, signal);
+		reader.replay();
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	remove("tiss_journal.bin");
+
+}
+#endif
+
+#if defined(__linux__)
+void test_ipc_signal()
+{
+
+	printf("test_ipc_signal\n");
+
+	namespace cr = std::chrono;
+
+	{
+		// another thread stands in for the other process, the path is the same
+		printf("tiss.ipc_signal emit -> wait: ");
+		tiss::ipc_signal<void(int, int)>::unlink("/tiss_test_ipc");
+		tiss::ipc_signal<void(int, int)> sub("/tiss_test_ipc", 1 << 16);
+		int received = 0;
+		int last = -1;
+		sub.connect([&](int i, int) { ++received; last = i; });
+		auto t0 = cr::high_resolution_clock::now();
+
+		std::thread producer([]() {
+			tiss::ipc_signal<void(int, int)> pub("/tiss_test_ipc");
+			for (int i = 0; i < 1000000; ++i) {
+				pub.emit(i, i);
+			}
+		});
+		while (last != 1000000 - 1) {
+			sub.wait(cr::milliseconds(10));
+		}
+		producer.join();
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count()
+			<< " (lost " << sub.lost() << ")" << std::endl;
+		tiss::ipc_signal<void(int, int)>::unlink("/tiss_test_ipc");
+	}
+	{
+		// trivially copyable arguments are read in place, the others go through the stage buffer
+		printf("tiss.ipc_signal zero copy and staged records: ");
+		static_assert(tiss::ipc_signal<void(int, double const &)>::zero_copy, "int, double are read in place");
+		static_assert(tiss::ipc_signal<void()>::zero_copy, "no arguments, nothing to stage");
+		static_assert(!tiss::ipc_signal<void(std::string, int)>::zero_copy, "a string is staged");
+
+		tiss::ipc_signal<void(int, double const &)>::unlink("/tiss_test_ipc_zc");
+		tiss::ipc_signal<void(int, double const &)> flat("/tiss_test_ipc_zc", 16);
+		double sum = 0;
+		flat.connect([&](int i, double const &d) { sum += i * d; });
+		for (int i = 1; i <= 4; ++i) flat.emit(i, 0.5);
+		size_t n = flat.poll();
+		assert(n == 4 && sum == 5.0);
+		tiss::ipc_signal<void(int, double const &)>::unlink("/tiss_test_ipc_zc");
+
+		tiss::ipc_signal<void(std::string, int)>::unlink("/tiss_test_ipc_st");
+		tiss::ipc_signal<void(std::string, int)> staged("/tiss_test_ipc_st", 16);
+		std::string text;
+		staged.connect([&](std::string s, int i) { text += s + std::to_string(i); });
+		staged.emit(std::string("a"), 1);
+		staged.emit(std::string("b"), 2);
+		n = staged.poll();
+		assert(n == 2 && text == "a1b2");
+		tiss::ipc_signal<void(std::string, int)>::unlink("/tiss_test_ipc_st");
+		std::cout << "ok" << std::endl;
+	}
+
+}
+#endif
+
+void test_throttled_invoke()
+{
+
+	printf("test_throttled_invoke\n");
+
+	namespace cr = std::chrono;
+
+	{
+		printf("tiss.signal, the slot reads a clock to throttle itself: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		auto last = cr::steady_clock::now();
+		signal.connect([&](int i, int &a) {
+			auto now = cr::steady_clock::now();
+			if (now - last >= cr::milliseconds(1)) {
+				last = now;
+				foo(i, a);
+			}
+		});
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a = 0;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal.connect_throttled, ticked every 1000 emissions: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		tiss::timer_wheel wheel(cr::milliseconds(1));
+		signal.connect_throttled(foo, cr::milliseconds(1), wheel);
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a = 0;
+			signal(i, a);
+			sum += a;
+			if (i % 1000 == 0) wheel.tick();
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+void test_relay_invoke()
+{
+
+	printf("test_relay_invoke\n");
+
+	namespace cr = std::chrono;
+
+	{
+		printf("tiss.signal, 3 levels relayed by lambdas: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> s0, s1, s2;
+		s2.connect(foo);
+		s1.connect([&](int i, int &a) { s2(i, a); });
+		s0.connect([&](int i, int &a) { s1(i, a); });
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			s0(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal, 3 levels relayed by connect_signal: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> s0, s1, s2;
+		s2.connect(foo);
+		s1.connect_signal(s2);
+		s0.connect_signal(s1);
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			s0(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+struct Receiver {
+	int fSum = 0;
+	void on_tick(int i) { fSum += i * x; }
+};
+
+void test_member_multicast_invoke()
+{
+
+	printf("test_member_multicast_invoke\n");
+
+	namespace cr = std::chrono;
+
+	std::vector<Receiver> receivers(10000);
+	{
+		printf("tiss.signal.connect_funcptr, one slot per object: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int)> signal;
+		for (auto &r : receivers) signal.connect_funcptr(&r, &Receiver::on_tick);
+		for (int i = 0; i < 1000; ++i) {
+			signal(i);
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.member_multicast: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int)> signal;
+		tiss::member_multicast<decltype(&Receiver::on_tick), &Receiver::on_tick> mc;
+		for (auto &r : receivers) mc.add(&r);
+		signal.connect_multicast(mc);
+		for (int i = 0; i < 1000; ++i) {
+			signal(i);
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+struct Handler {
+	void handle(int i, int &a) { foo(i, a); }
+};
+
+void test_static_member_invoke()
+{
+
+	printf("test_static_member_invoke\n");
+
+	namespace cr = std::chrono;
+
+	Handler handler;
+	{
+		printf("tiss.signal.connect_funcptr(&obj, &T::f): ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect_funcptr(&handler, &Handler::handle);
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal.connect<T, &T::f>(&obj): ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect<Handler, &Handler::handle>(&handler);
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal.connect_funcptr(foo): ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect_funcptr(foo);
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal.connect<&foo>(): ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect<&foo>();
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+void test_nested_invoke()
+{
+
+	printf("test_nested_invoke\n");
+
+	namespace cr = std::chrono;
+
+	{
+		printf("tiss.signal, slot emits the signal again, 8 levels: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect([&](int i, int &a) { if (i & 7) signal(i - 1, a); });
+		signal.connect(foo);
+		auto sum = 0;
+		for (int i = 0; i < 1000000; ++i) {
+			int a;
+			signal(i | 7, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		// the slot is still linked while the nested emissions walk over it
+		printf("tiss.signal, slot disconnects itself then emits again: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect(foo);
+		int calls = 0;
+		uint32_t max_depth = 0;
+		for (int i = 0; i < 1000000; ++i) {
+			tiss::connection self;
+			self = signal.connect([&](int i, int &a) {
+				self.disconnect();
+				if (signal.emit_depth() > max_depth) max_depth = signal.emit_depth();
+				signal(i, a);
+			});
+			int a;
+			signal(i, a);
+			++calls;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << " (" << calls << " emissions, max depth " << max_depth << ")" << std::endl;
+	}
+
+}
+
+// a slot with a table built by its constructor
+struct TableSlot {
+	std::vector<int> fTable;
+	TableSlot(size_t n) : fTable(n) {
+		for (size_t i = 0; i < n; ++i) fTable[i] = (int)(i * i);
+	}
+	void operator()(int i, int &a) { a = fTable[i % fTable.size()]; }
+};
+
+void test_lazy_connect()
+{
+
+	printf("test_lazy_connect\n");
+
+	namespace cr = std::chrono;
+
+	{
+		printf("tiss.signal.connect_emplace<TableSlot>(4096) x 10000: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		for (int i = 0; i < 10000; ++i) {
+			signal.connect_emplace<TableSlot>(4096);
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal.connect_lazy<TableSlot>(4096) x 10000: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		for (int i = 0; i < 10000; ++i) {
+			signal.connect_lazy<TableSlot>(4096);
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.signal.connect_lazy<TableSlot>(4096), invoke: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		signal.connect_lazy<TableSlot>(4096);
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+	{
+		// materialize_all builds the lazy slots only, a functor of the user's may have its own Materialize()
+		printf("tiss.signal.materialize_all, lazy and user slots: ");
+		struct own_materialize {
+			int *fCalls;
+			bool Materialize() { ++*fCalls; return true; }
+			void operator()(int, int &) { }
+		};
+		tiss::signal<void(int, int&)> signal;
+		int calls = 0;
+		signal.connect(own_materialize{ &calls });
+		signal.connect_lazy<TableSlot>(16);
+		size_t built = signal.materialize_all();
+		assert(built == 1 && calls == 0);
+		printf("ok\n");
+	}
+	{
+		printf("tiss.signal.connect_lazy, arguments released once built: ");
+		struct Holder {
+			std::shared_ptr<int> fKept;
+			Holder(std::shared_ptr<int> const &p, bool fail) : fKept(p) { if (fail) throw 1; }
+			void operator()(int, int &) { }
+		};
+		auto probe = std::make_shared<int>(0);
+		tiss::signal<void(int, int&)> signal;
+		signal.connect_lazy<Holder>(probe, true);
+		signal.connect_lazy<Holder>(probe, false);
+		assert(probe.use_count() == 3);
+		// the first one throws, it keeps its arguments and is tried again later
+		bool thrown = false;
+		try { signal.materialize_all(); } catch (int) { thrown = true; }
+		assert(thrown && probe.use_count() == 3);
+		signal.disconnect_all();
+		assert(probe.use_count() == 1);
+		signal.connect_lazy<Holder>(probe, false);
+		assert(signal.materialize_all() == 1);
+		// the object holds a copy, the stored argument is gone
+		assert(probe.use_count() == 2);
+		signal.disconnect_all();
+		assert(probe.use_count() == 1);
+		printf("ok\n");
+	}
+}
+
+void test_inline_signal()
+{
+
+	printf("test_inline_signal\n");
+
+	namespace cr = std::chrono;
+
+	{
+		printf("tiss.signal, connect + disconnect: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(int, int&)> signal;
+		for (int i = 0; i < 10000000; ++i) {
+			signal.connect(foo).disconnect();
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.inline_signal<4>, connect + disconnect: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::inline_signal<void(int, int&), 4> signal;
+		for (int i = 0; i < 10000000; ++i) {
+			signal.connect(foo).disconnect();
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.inline_signal<4>, invoke: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::inline_signal<void(int, int&), 4> signal;
+		signal.connect(foo);
+		auto sum = 0;
+		for (int i = 0; i < 10000000; ++i) {
+			int a;
+			signal(i, a);
+			sum += a;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+// a slot owning a large container
+struct HeavySlot {
+	std::vector<std::string> fNames;
+	char fPad[64];
+	void operator()(int, int &a) { a = (int)fNames.size(); }
+};
+
+void test_deferred_reclaim()
+{
+
+	printf("test_deferred_reclaim\n");
+
+	namespace cr = std::chrono;
+
+	for (auto policy : { tiss::reclaim_policy::immediate, tiss::reclaim_policy::deferred }) {
+		bool deferred = policy == tiss::reclaim_policy::deferred;
+		tiss::signal<void(int, int&)> signal;
+		signal.set_reclaim_policy(policy);
+		for (int i = 0; i < 1000; ++i) {
+			signal.connect(HeavySlot{ std::vector<std::string>(1000, "a name longer than the sso buffer"), {} });
+		}
+
+		printf(deferred ? "tiss.signal, deferred, disconnect 1000 heavy slots: " : "tiss.signal, immediate, disconnect 1000 heavy slots: ");
+		auto t0 = cr::high_resolution_clock::now();
+		signal.disconnect_all();
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::microseconds>(t1 - t0).count() << "us" << std::endl;
+
+		if (deferred) {
+			printf("tiss.collect(): ");
+			auto t2 = cr::high_resolution_clock::now();
+			tiss::collect();
+			auto t3 = cr::high_resolution_clock::now();
+			std::cout << cr::duration_cast<cr::microseconds>(t3 - t2).count() << "us" << std::endl;
+		}
+	}
+
+}
+
+struct Tick {
+	uint64_t seq;
+	int value;
+};
+
+void test_join_invoke()
+{
+
+	printf("test_join_invoke\n");
+
+	namespace cr = std::chrono;
+
+	{
+		printf("tiss.signal x 3, joined by hand with a map: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(Tick const &)> s0, s1, s2;
+		struct partial { int mask = 0; int sum = 0; };
+		std::unordered_map<uint64_t, partial> pending;
+		auto sum = 0;
+		auto on_tick = [&](int bit, Tick const &t) {
+			auto &p = pending[t.seq];
+			p.mask |= bit;
+			p.sum += t.value;
+			if (p.mask == 7) {
+				sum += p.sum;
+				pending.erase(t.seq);
+			}
+		};
+		s0.connect([&](Tick const &t) { on_tick(1, t); });
+		s1.connect([&](Tick const &t) { on_tick(2, t); });
+		s2.connect([&](Tick const &t) { on_tick(4, t); });
+		for (int i = 0; i < 3000000; ++i) {
+			s0(Tick{ (uint64_t)i, 1 });
+			s1(Tick{ (uint64_t)i, 2 });
+			s2(Tick{ (uint64_t)i, 3 });
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.join x 3: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::signal<void(Tick const &)> s0, s1, s2;
+		auto sum = 0;
+		tiss::join(s0, s1, s2, [](Tick const &t) { return t.seq; })
+			.connect([&](Tick const &a, Tick const &b, Tick const &c) { sum += a.value + b.value + c.value; });
+		for (int i = 0; i < 3000000; ++i) {
+			s0(Tick{ (uint64_t)i, 1 });
+			s1(Tick{ (uint64_t)i, 2 });
+			s2(Tick{ (uint64_t)i, 3 });
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+struct Widget {
+	Widget *parent;
+	tiss::signal<bool(int&)> capture;
+	tiss::signal<bool(int&)> bubble;
+};
+
+void test_propagation_invoke()
+{
+
+	printf("test_propagation_invoke\n");
+
+	namespace cr = std::chrono;
+
+	const int depth = 16;
+	{
+		printf("tiss.signal, walk parent pointers, 16 levels: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		std::vector<Widget> widgets(depth);
+		for (int i = 0; i < depth; ++i) {
+			widgets[i].parent = i ? &widgets[i - 1] : nullptr;
+			widgets[i].capture.connect([](int &e) { ++e; return true; });
+			widgets[i].bubble.connect([](int &e) { ++e; return true; });
+		}
+		auto sum = 0;
+		std::vector<Widget*> path;
+		for (int i = 0; i < 1000000; ++i) {
+			int e = 0;
+			path.clear();
+			for (Widget *w = &widgets[depth - 1]; w; w = w->parent) path.push_back(w);
+			bool go = true;
+			for (size_t j = path.size(); go && j-- > 0; ) go = path[j]->capture.emit_util_false(e);
+			for (size_t j = 0; go && j < path.size(); ++j) go = path[j]->bubble.emit_util_false(e);
+			sum += e;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+	{
+		printf("tiss.propagation_tree, 16 levels: ");
+		auto t0 = cr::high_resolution_clock::now();
+
+		tiss::propagation_tree<int> tree;
+		auto node = tree.no_node;
+		for (int i = 0; i < depth; ++i) {
+			node = tree.add(node);
+			tree.capture(node).connect([](int &e) { ++e; return true; });
+			tree.bubble(node).connect([](int &e) { ++e; return true; });
+		}
+		auto sum = 0;
+		for (int i = 0; i < 1000000; ++i) {
+			int e = 0;
+			tree.dispatch(node, e);
+			sum += e;
+		}
+
+		auto t1 = cr::high_resolution_clock::now();
+		std::cout << cr::duration_cast<cr::milliseconds>(t1 - t0).count() << std::endl;
+	}
+
+}
+
+void test_topic_bus_nested()
+{
+
+	printf("test_topic_bus_nested\n");
+
+	// a slot subscribes and interns while publish walks the topic, then publishes again
+	tiss::topic_bus<void(int)> bus;
+	int calls = 0, star = 0, late = 0;
+	bus.subscribe("a.b", [&](int depth) {
+		++calls;
+		if (depth > 0) return;
+		for (int i = 0; i < 100; ++i) {
+			bus.subscribe("a.*." + std::to_string(i), [](int) {});
+			bus.intern("t." + std::to_string(i));
+		}
+		bus.subscribe("a.#", [&](int) { ++late; });
+		bus.publish("a.b", depth + 1);
+	});
+	bus.subscribe("*.b", [&](int) { ++star; });
+	bus.publish("a.b", 0);
+	// the outer publish goes on after the nested one, and reaches "a.#" too, as it was added during the walk
+	assert(calls == 2 && star == 2 && late == 2);
+
+	// publishing by name doesn't intern, only intern() adds a topic
+	size_t topics = bus.num_topics();
+	for (int i = 0; i < 1000; ++i) bus.publish("x." + std::to_string(i) + ".b", 1);
+	assert(bus.num_topics() == topics);
+	auto id = bus.intern("a.b");
+	assert(bus.num_topics() == topics + 1);
+	calls = star = late = 0;
+	bus.publish(id, 1);
+	bus.publish("a.b", 1);
+	assert(calls == 2 && star == 2 && late == 2);
+	printf("ok\n");
+
+}
+
+void test_inline_signal_outlived()
+{
+
+	printf("test_inline_signal_outlived\n");
+
+	tiss::connection a, b;
+	{
+		tiss::inline_signal<void(int, int&), 2> signal;
+		a = signal.connect(foo);
+		b = signal.connect(foo);
+		tiss::connection c = b;
+		b.disconnect();
+		// c still holds the slot of b
+		assert(signal.free_slots() == 0 && !signal.connect(foo).connected());
+		c = tiss::connection();
+		assert(signal.free_slots() == 1);
+		b = signal.connect(foo);
+		assert(b.connected());
+	}
+	// the handles outlived the signal, they see a disconnected slot
+	assert(!a.connected() && !b.connected());
+	a.disconnect();
+	b = tiss::connection();
+	printf("ok\n");
+
+}
+
+void test_deferred_reclaim_internal()
+{
+
+	printf("test_deferred_reclaim_internal\n");
+
+	// the slots of the library are destroyed on the owning thread, never by collect()
+	tiss::signal<void(int, int&)> s0, s1, s2;
+	tiss::timer_wheel wheel;
+	for (auto *s : { &s0, &s1 }) s->set_reclaim_policy(tiss::reclaim_policy::deferred);
+	// no handle is kept, the bodies are free to go to the queue
+	s0.connect_signal(s2);
+	s0.connect_throttled([](int, int &) { }, std::chrono::milliseconds(1), wheel);
+	tiss::join(s0, s1, [](int i, int const &) { return i; }).connect([](int, int &, int, int &) { });
+	s0.disconnect_all();
+	s1.disconnect_all();
+	assert(tiss::collect() == 0);
+	// a user functor is deferred
+	s0.connect([](int, int &) { });
+	s0.disconnect_all();
+	assert(tiss::collect() == 1);
+	printf("ok\n");
+
+}
+
+void test_timer_wheel_boundary()
+{
+
+	printf("test_timer_wheel_boundary\n");
+
+	// deadlines on a multiple of 64 come down from an upper level on the tick they are due
+	struct probe : tiss::details::wheel_timer {
+		uint64_t fFiredAt = 0;
+		probe(tiss::timer_wheel &wheel) : wheel_timer(wheel) { }
+		void Fire() override { fFiredAt = fWheel->now(); }
+	};
+	tiss::timer_wheel wheel;
+	probe a(wheel), b(wheel), c(wheel);
+	wheel.Schedule(&a, 64);
+	wheel.Schedule(&b, 4096);
+	wheel.Schedule(&c, 4097);
+	wheel.advance(5000);
+	assert(a.fFiredAt == 64 && b.fFiredAt == 4096 && c.fFiredAt == 4097);
+	assert(wheel.num_timers() == 0);
+	printf("ok\n");
+
+}
+
+void test_emit_cursor_assign()
+{
+
+	printf("test_emit_cursor_assign\n");
+
+	// a cursor kept across ticks, restarted before the last emission is done
+	tiss::signal<void(int, int&)> s;
+	int calls = 0;
+	for (int i = 0; i < 3; ++i) s.connect([&](int i, int &a) { ++calls; a += i; });
+	tiss::signal<void(int, int&)>::emit_cursor_type cursor;
+	assert(cursor.done());
+	auto past = std::chrono::steady_clock::now();
+	int a = 0, b = 0;
+	cursor = s.emit_budgeted(past, 1, a);
+	assert(!cursor.done() && calls == 1);
+	// the pin on the second slot is released, a is not assigned through
+	cursor = s.emit_budgeted(past, 10, b);
+	assert(calls == 2 && a == 1 && b == 10);
+	while (!s.resume(cursor, past)) {}
+	assert(calls == 4 && a == 1 && b == 30);
+	s.disconnect_all();
+	cursor = tiss::signal<void(int, int&)>::emit_cursor_type();
+	assert(cursor.done());
+	printf("ok\n");
+
+}
+
+#if TISS_ALLOC_ACCOUNTING
+void test_no_alloc_emit()
+{
+
+	printf("test_no_alloc_emit\n");
+
+	struct big { char fPad[128]; int operator()(int i) const { return fPad[i & 127]; } };
+	tiss::signal<void(int, int&)> s;
+	big b{};
+	s.connect([](int i, int &a) { foo(i, a); });
+	s.connect([b](int i, int &a) { a += b(i); });
+	tiss::thread_alloc_stats() = tiss::alloc_stats();
+	{
+		tiss::no_alloc_scope scope;
+		for (int i = 0; i < 1000; ++i) {
+			int a = 0;
+			s(i, a);
+		}
+	}
+	assert(tiss::thread_alloc_stats().count_of(tiss::alloc_phase::emit) == 0);
+
+	// a queued slot allocates a message per emission, the accounting sees it
+	tiss::thread_context ctx;
+	s.connect([](int, int &) { }, ctx);
+	int a = 0;
+	s(1, a);
+	assert(tiss::thread_alloc_stats().count_of(tiss::alloc_phase::emit) == 1);
+	ctx.pump();
+	printf("ok\n");
+
+}
+#endif
+
+void test_queued_self_post()
+{
+
+	printf("test_queued_self_post\n");
+
+	// the thread pumping the context emits into its own full mailbox, it can't wait for itself
+	tiss::thread_context ctx;
+	tiss::queue_options opts;
+	opts.capacity = 2;
+	opts.policy = tiss::queue_policy::block;
+	tiss::signal<void(int)> s;
+	std::vector<int> seen;
+	s.connect([&](int i) { seen.push_back(i); }, ctx, opts);
+	ctx.pump();
+	for (int i = 0; i < 5; ++i) s(i);
+	ctx.pump();
+	assert((seen == std::vector<int>{ 0, 1, 2, 3, 4 }));
+
+	// a queued slot posting twice into its own mailbox, from inside pump()
+	tiss::signal<void(int)> t;
+	int runs = 0;
+	t.connect([&](int depth) {
+		++runs;
+		if (depth < 4) {
+			t(depth + 1);
+			t(depth + 1);
+		}
+	}, ctx, opts);
+	t(0);
+	while (ctx.pump()) {}
+	assert(runs == 31);
+	printf("ok\n");
+
+}
+
+#if TISS_ALLOC_ACCOUNTING
+void test_inline_signal_alloc()
+{
+
+	printf("test_inline_signal_alloc\n");
+
+	// the tombstones can't live in the signal, a handle may outlive it
+	// so the first connect allocates their block, and nothing else does
+	auto count = []() {
+		auto &stats = tiss::thread_alloc_stats();
+		return stats.count_of(tiss::alloc_phase::other) + stats.count_of(tiss::alloc_phase::connect)
+			+ stats.count_of(tiss::alloc_phase::emit) + stats.count_of(tiss::alloc_phase::disconnect);
+	};
+	tiss::thread_alloc_stats() = tiss::alloc_stats();
+	{
+		tiss::inline_signal<void(int, int&), 4> s;
+		assert(count() == 0);
+		auto c = s.connect([](int i, int &a) { a += i; });
+		assert(count() == 1);
+		s.connect([](int i, int &a) { a -= i; });
+		int a = 0;
+		s(1, a);
+		c.disconnect();
+		s.disconnect_all();
+		s.connect([](int i, int &a) { a += i; });
+		assert(count() == 1);
+	}
+	printf("ok\n");
+
+}
+#endif
+
+// what deferred reclaim does with a handle still held
+// a large functor is deferred, its handle points at a tombstone
+// a small one has its handle on the body, the body can't go to the queue and its functor is destroyed inline
+void test_deferred_reclaim_held()
+{
+
+	printf("test_deferred_reclaim_held\n");
+
+	tiss::collect();
+	auto probe = std::make_shared<int>(0);
+	struct Small {
+		std::shared_ptr<int> fProbe;
+		void operator()(int, int &) {}
+	};
+	struct Large {
+		std::shared_ptr<int> fProbe;
+		char fPad[TISS_RECLAIM_MIN_FUNCTOR];
+		void operator()(int, int &) {}
+	};
+
+	tiss::signal<void(int, int&)> signal;
+	signal.set_reclaim_policy(tiss::reclaim_policy::deferred);
+
+	auto small = signal.connect(Small{ probe });
+	auto large = signal.connect(Large{ probe, {} });
+	assert(probe.use_count() == 3);
+
+	small.disconnect();
+	assert(probe.use_count() == 2); // the small functor is gone already
+	large.disconnect();
+	assert(probe.use_count() == 2); // the large one waits for collect()
+	assert(tiss::collect() == 1);
+	assert(probe.use_count() == 1);
+
+	// the same for disconnect_all, with copies of the handles kept
+	small = signal.connect(Small{ probe });
+	large = signal.connect(Large{ probe, {} });
+	signal.disconnect_all();
+	assert(probe.use_count() == 2 && !small.connected() && !large.connected());
+	assert(tiss::collect() == 1);
+	assert(probe.use_count() == 1);
+
+	// dropping the handle first lets the small one be deferred too
+	small = signal.connect(Small{ probe });
+	small = tiss::connection();
+	signal.disconnect_all();
+	assert(probe.use_count() == 2);
+	assert(tiss::collect() == 1);
+	assert(probe.use_count() == 1);
+
+}
+
+void test_computed_lifetime()
+{
+
+	printf("test_computed_lifetime\n");
+
+	tiss::property<int> x(1);
+
+	// the function is kept by its own type, a move only one is fine
+	std::unique_ptr<int> scale(new int(10));
+	tiss::computed<int> scaled(x, [scale = std::move(scale)](int v) { return v * *scale; });
+	int seen = 0;
+	scaled.changed.connect([&](int v) { seen = v; });
+	x.set(2);
+	assert(seen == 20);
+
+	// destroyed in the transaction that queued it
+	{
+		tiss::transaction tx;
+		std::unique_ptr<tiss::computed<int> > doomed(new tiss::computed<int>(x, [](int v) { return v + 1; }));
+		doomed->changed.connect([](int) { assert(false); });
+		x.set(3);
+		doomed.reset();
+	}
+	assert(seen == 30);
+
+	// destroyed by the listener of a node notified before it
+	std::unique_ptr<tiss::computed<int> > later(new tiss::computed<int>(scaled, [](int v) { return v + 1; }));
+	int later_seen = 0;
+	later->changed.connect([&](int v) { later_seen = v; });
+	auto c = x.changed.connect([&](int) { later.reset(); });
+	x.set(4);
+	assert(seen == 40 && later_seen == 0 && !later);
+	printf("ok\n");
+
+}
+
 int main()
 {
 	test_invoke();
@@ -418,5 +1580,36 @@ int main()
 	test_heavy_para_invoke();
 	test_connect();
 	test_heavy_lambda_connect();
+	test_keyed_invoke();
+	test_pipeline_invoke();
+	test_connect_many();
+#if defined(__linux__)
+	test_journal();
+	test_ipc_signal();
+#endif
+	test_throttled_invoke();
+	test_relay_invoke();
+	test_member_multicast_invoke();
+	test_static_member_invoke();
+	test_nested_invoke();
+	test_lazy_connect();
+	test_inline_signal();
+	test_deferred_reclaim();
+	test_join_invoke();
+	test_propagation_invoke();
+	test_topic_bus_nested();
+	test_inline_signal_outlived();
+	test_deferred_reclaim_internal();
+	test_timer_wheel_boundary();
+	test_emit_cursor_assign();
+#if TISS_ALLOC_ACCOUNTING
+	test_no_alloc_emit();
+#endif
+	test_queued_self_post();
+#if TISS_ALLOC_ACCOUNTING
+	test_inline_signal_alloc();
+#endif
+	test_deferred_reclaim_held();
+	test_computed_lifetime();
 	return 0;
 }
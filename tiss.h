@@ -2,13 +2,224 @@
 #define TISS_H
 
 #include <utility>
+#include <cstdint>
 #include <memory>
 #include <type_traits>
 #include <functional>
 #include <tuple>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <array>
+#include <deque>
+
+// keep cold code out of line, so it exists once in the binary
+#if defined(_MSC_VER)
+#define TISS_NOINLINE __declspec(noinline)
+#else
+#define TISS_NOINLINE __attribute__((noinline))
+#endif
+
+// allocation accounting
+// #define TISS_ALLOC_ACCOUNTING 1 before including tiss.h
+// the allocations made by the library are counted per thread and per phase (connect/emit/disconnect)
+// and tiss::no_alloc_scope can check that emission doesn't allocate
+// the library's own allocations are connection bodies, connect_many blocks, mailboxes, queue nodes and rings
+// containers of the helpers (topic_bus, keyed_signal, slot table) use std::allocator and are not seen
+// unless TISS_DEFINE_ALLOC_HOOKS is defined in exactly one translation unit
+// then the global operator new is replaced and every allocation is counted, argument copies included
+#ifndef TISS_ALLOC_ACCOUNTING
+#define TISS_ALLOC_ACCOUNTING 0
+#endif
+
+#if TISS_ALLOC_ACCOUNTING
+#include <cstdio>
+#include <cstdlib>
+#define TISS_ALLOC_PHASE(phase) ::tiss::details::alloc_phase_scope tiss_alloc_phase_(::tiss::alloc_phase::phase)
+#else
+#define TISS_ALLOC_PHASE(phase)
+#endif
+
+// signal registry
+// #define TISS_REGISTRY 1 before including tiss.h
+// every signal registers itself at construction, tiss::registry_snapshot() and tiss::registry_dump_json()
+// list name, signature, live slots and their bytes, slots disconnected but kept alive by connection handles
+// and the number of emissions, an emission relayed to it by connect_signal counts as one
+#ifndef TISS_REGISTRY
+#define TISS_REGISTRY 0
+#endif
+
+#if TISS_REGISTRY
+#include <mutex>
+#include <typeinfo>
+#include <cstdio>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+#define TISS_COUNT_EMIT(state) ::tiss::details::bump((state).fRecord->fEmissions, 1)
+#else
+#define TISS_COUNT_EMIT(state)
+#endif
+
+// emission journal
+// #define TISS_JOURNAL 1 before including tiss.h, POSIX only
+// tiss::journal records the emissions of chosen signals into a memory-mapped ring file
+// tiss::journal_reader re-emits them into the slots of the same signals
+#ifndef TISS_JOURNAL
+#define TISS_JOURNAL 0
+#endif
+
+// cross-process signals
+// #define TISS_IPC 1 before including tiss.h, Linux only
+// tiss::ipc_signal passes emissions through a named shared-memory ring to the other processes on the host
+#ifndef TISS_IPC
+#define TISS_IPC 0
+#endif
+
+#if TISS_JOURNAL || TISS_IPC
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if TISS_IPC
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <climits>
+#endif
+
+// slots whose functor is at least this large are reclaimed as soon as they are disconnected
+// the connection handles still out there keep a small tombstone instead of the whole body
+#ifndef TISS_RECLAIM_MIN_FUNCTOR
+#define TISS_RECLAIM_MIN_FUNCTOR 64
+#endif
 
 namespace tiss {
 
+	enum class alloc_phase {
+		other,
+		connect,
+		emit,
+		disconnect,
+	};
+
+	struct alloc_stats {
+		size_t count[4] = {};
+		size_t bytes[4] = {};
+
+		size_t count_of(alloc_phase phase) const { return count[(size_t)phase]; }
+		size_t bytes_of(alloc_phase phase) const { return bytes[(size_t)phase]; }
+	};
+
+	// stats of the calling thread, all zero unless TISS_ALLOC_ACCOUNTING
+	inline alloc_stats &thread_alloc_stats()
+	{
+		static thread_local alloc_stats stats;
+		return stats;
+	}
+
+	namespace details {
+
+#if TISS_ALLOC_ACCOUNTING
+		inline alloc_phase &current_alloc_phase()
+		{
+			static thread_local alloc_phase phase = alloc_phase::other;
+			return phase;
+		}
+
+		// set by TISS_DEFINE_ALLOC_HOOKS, the global operator new counts then
+		inline bool &global_alloc_hooks()
+		{
+			static bool installed = false;
+			return installed;
+		}
+
+		struct alloc_phase_scope {
+			alloc_phase fOld;
+			alloc_phase_scope(alloc_phase phase) : fOld(current_alloc_phase()) {
+				current_alloc_phase() = phase;
+			}
+			~alloc_phase_scope() {
+				current_alloc_phase() = fOld;
+			}
+		};
+
+		inline void note_alloc(size_t bytes)
+		{
+			auto &stats = thread_alloc_stats();
+			size_t phase = (size_t)current_alloc_phase();
+			stats.count[phase] += 1;
+			stats.bytes[phase] += bytes;
+		}
+
+		// the library's own allocations, not counted twice if the global hooks are there
+		inline void note_library_alloc(size_t bytes)
+		{
+			if (!global_alloc_hooks()) note_alloc(bytes);
+		}
+#else
+		inline void note_library_alloc(size_t) { }
+#endif
+
+		inline void *allocate(size_t bytes)
+		{
+			note_library_alloc(bytes);
+			return ::operator new(bytes);
+		}
+
+		inline void deallocate(void *p)
+		{
+			::operator delete(p);
+		}
+	}
+
+#if TISS_ALLOC_ACCOUNTING
+	using alloc_failure_handler = void(*)(size_t allocations, size_t bytes);
+
+	inline alloc_failure_handler &no_alloc_failure_handler()
+	{
+		static alloc_failure_handler handler = [](size_t allocations, size_t bytes) {
+			fprintf(stderr, "tiss::no_alloc_scope: emission allocated %zu times (%zu bytes)\n", allocations, bytes);
+			abort();
+		};
+		return handler;
+	}
+
+	// fails (calls no_alloc_failure_handler) at the end of the scope
+	// if an emission inside the scope allocated on this thread
+	class no_alloc_scope {
+	public:
+		no_alloc_scope() :
+			fCount(thread_alloc_stats().count_of(alloc_phase::emit)),
+			fBytes(thread_alloc_stats().bytes_of(alloc_phase::emit))
+		{
+		}
+
+		no_alloc_scope(no_alloc_scope const &) = delete;
+		no_alloc_scope &operator=(no_alloc_scope const &) = delete;
+
+		~no_alloc_scope() {
+			if (allocations()) no_alloc_failure_handler()(allocations(), bytes());
+		}
+
+		size_t allocations() const { return thread_alloc_stats().count_of(alloc_phase::emit) - fCount; }
+		size_t bytes() const { return thread_alloc_stats().bytes_of(alloc_phase::emit) - fBytes; }
+
+	private:
+		size_t fCount;
+		size_t fBytes;
+	};
+#endif
+
 	namespace details {
 
 		struct linked {
@@ -28,9 +239,215 @@ namespace tiss {
 				fPrev = p;
 			}
 
+			// if we are list header
+			// append the chain first..last, which is linked already
+			void splice_back(linked *first, linked *last) {
+				first->fPrev = fPrev;
+				last->fNext = this;
+				fPrev->fNext = first;
+				fPrev = last;
+			}
+
 			bool empty() { return fPrev == this; }
 		};
 
+		// output iterator that drops everything
+		struct discard_iterator {
+			discard_iterator &operator*() { return *this; }
+			discard_iterator &operator++() { return *this; }
+			discard_iterator operator++(int) { return *this; }
+			template<class T>
+			discard_iterator &operator=(T const &) { return *this; }
+		};
+
+		// fBlockIndex of a body allocated alone
+		static const uint32_t no_block = (uint32_t(1) << 31) - 1;
+		// fBlockIndex of a body living in an inline_signal
+		static const uint32_t inline_block = no_block - 1;
+
+		struct tombstone;
+		struct inline_tombstones;
+
+		// precedes every slot of an inline_signal, the body follows at inline_header_size
+		// the handles of the body go through fOwn, the tombstone of the slot in the signal's block,
+		// so they outlive the signal, and the slot is taken until the last one goes
+		struct inline_slot_header {
+			tombstone *fTombstone; // fOwn while it is attached to the body
+			tombstone *fOwn;       // null until the slot has had a handle
+			inline_tombstones *fTombstones;
+			size_t fIndex;
+			bool fUsed;
+		};
+		static const size_t inline_header_size = (sizeof(inline_slot_header) + alignof(std::max_align_t) - 1)
+			/ alignof(std::max_align_t) * alignof(std::max_align_t);
+
+		inline inline_slot_header *inline_slot_of(void *body)
+		{
+			return (inline_slot_header*)((char*)body - inline_header_size);
+		}
+
+		// header of a memory block holding several bodies, see signal_impl::connect_many
+		// the block is freed when the last body in it is freed
+		struct body_block {
+			size_t fLive;
+
+			void Release() {
+				if (--fLive == 0) deallocate((void*)this);
+			}
+		};
+
+		// fSlotIndex of a body that has no entry in the slot table
+		static const uint32_t no_slot = (uint32_t(1) << 30) - 1;
+
+#if TISS_REGISTRY
+		struct signal_record {
+			uint32_t fId;
+			bool fAlive = true;
+			std::string fName;
+			std::string fSignature;
+			// written by the thread owning the signal, read by the dump
+			std::atomic<size_t> fEmissions{ 0 };
+			std::atomic<size_t> fLive{ 0 };
+			std::atomic<size_t> fLiveBytes{ 0 };
+			// disconnected bodies kept alive by connection handles, any thread
+			std::atomic<size_t> fPinned{ 0 };
+			std::atomic<size_t> fPinnedBytes{ 0 };
+		};
+
+		// single writer, no need of a locked add
+		inline void bump(std::atomic<size_t> &a, ptrdiff_t d)
+		{
+			a.store(a.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+		}
+
+		struct signal_registry {
+			std::mutex fMutex;
+			std::vector<signal_record*> fRecords; // indexed by fId, null if free
+			std::vector<uint32_t> fFree;
+
+			signal_record *Add() {
+				std::lock_guard<std::mutex> lock(fMutex);
+				auto *r = new signal_record();
+				if (fFree.empty()) {
+					r->fId = (uint32_t)fRecords.size();
+					fRecords.push_back(r);
+				} else {
+					r->fId = fFree.back();
+					fFree.pop_back();
+					fRecords[r->fId] = r;
+				}
+				return r;
+			}
+
+			// the record stays while handles pin bodies of the dead signal
+			void SignalGone(signal_record *r) {
+				std::lock_guard<std::mutex> lock(fMutex);
+				r->fAlive = false;
+				FreeIfUnused(r);
+			}
+
+			void Pin(signal_record *r, size_t bytes) {
+				r->fPinned.fetch_add(1, std::memory_order_relaxed);
+				r->fPinnedBytes.fetch_add(bytes, std::memory_order_relaxed);
+			}
+
+			void Unpin(uint32_t id, size_t bytes) {
+				std::lock_guard<std::mutex> lock(fMutex);
+				auto *r = fRecords[id];
+				r->fPinned.fetch_sub(1, std::memory_order_relaxed);
+				r->fPinnedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+				FreeIfUnused(r);
+			}
+
+			void FreeIfUnused(signal_record *r) {
+				if (!r->fAlive && r->fPinned.load(std::memory_order_relaxed) == 0) {
+					fRecords[r->fId] = nullptr;
+					fFree.push_back(r->fId);
+					delete r;
+				}
+			}
+		};
+
+		inline std::string demangle(char const *name)
+		{
+#if defined(__GNUG__)
+			int status = 0;
+			char *readable = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+			if (readable) {
+				std::string str = readable;
+				free(readable);
+				return str;
+			}
+#endif
+			return name;
+		}
+
+		// never destroyed, signals with static storage may go away after it otherwise
+		inline signal_registry &registry()
+		{
+			static signal_registry *r = new signal_registry();
+			return *r;
+		}
+#endif
+
+		// the part of a signal that bodies may reach
+		// the connected slots counter, and the table behind slot_handle
+		// a table entry is {body, generation}, the generation is bumped when the slot goes away
+		struct signal_state {
+			struct slot_entry {
+				void *fBody;
+				uint32_t fGeneration;
+				uint32_t fNextFree;
+			};
+
+			size_t fNumConnections = 0;
+			std::vector<slot_entry> fSlots;
+			uint32_t fFreeSlot = no_slot;
+			mutable uint32_t fEmitDepth = 0; // emissions in progress, > 1 when reentrant
+			bool fDeferReclaim = false; // see reclaim_policy
+#if TISS_REGISTRY
+			signal_record *fRecord = nullptr;
+#endif
+
+			uint32_t AcquireSlot(void *body) {
+				uint32_t idx = fFreeSlot;
+				if (idx != no_slot) {
+					fFreeSlot = fSlots[idx].fNextFree;
+				} else {
+					idx = (uint32_t)fSlots.size();
+					fSlots.push_back(slot_entry{ nullptr, 0, no_slot });
+				}
+				fSlots[idx].fBody = body;
+				return idx;
+			}
+
+			// called by the body when it is disconnected
+			void Disconnected(uint32_t slot) {
+				--fNumConnections;
+#if TISS_REGISTRY
+				bump(fRecord->fLive, -1);
+#endif
+				if (slot != no_slot) {
+					auto &e = fSlots[slot];
+					e.fBody = nullptr;
+					++e.fGeneration; // outstanding handles are stale now
+					e.fNextFree = fFreeSlot;
+					fFreeSlot = slot;
+				}
+			}
+		};
+
+		// counts the emissions of a signal on the stack
+		struct emit_scope {
+			signal_state const &fState;
+			explicit emit_scope(signal_state const &state) : fState(state) { ++fState.fEmitDepth; }
+			~emit_scope() { --fState.fEmitDepth; }
+			emit_scope(emit_scope const &) = delete;
+			emit_scope &operator=(emit_scope const &) = delete;
+		};
+
+		struct tombstone;
+
 		template<class T>
 		struct copy_forward_type_impl {
 			using type = T const &;
@@ -78,7 +495,16 @@ namespace tiss {
 		connection_body_vptr &operator=(connection_body_vptr &&r) = delete;
 
 		virtual void Destroy() = 0;
-
+		// free the memory, the derived class knows its size and where it was allocated
+		virtual void DeleteThis() = 0;
+		// sizeof the derived class, for the registry
+		virtual size_t BodySize() const = 0;
+		// where a reclaimable body keeps its tombstone
+		virtual details::tombstone **TombstoneSlot() { return nullptr; }
+		// build the functor of a lazy slot now, true if it was not built yet
+		virtual bool Materialize() { return false; }
+		// the functor must be destroyed on the thread owning the signal, see reclaim_policy
+		virtual bool OwnerThreadOnly() const { return false; }
 
 	};
 
@@ -90,12 +516,25 @@ namespace tiss {
 		// fNext
 		// fWeakRef
 		// fStrongRef
-		// fConnected
+		// fOwner
+		// fBlockIndex, fReclaim
+		// fSlotIndex, fForward, fConnected
+
+		uint32_t fWeakRef;
+		uint32_t fStrongRef;
+		details::signal_state *fOwner = nullptr; // kept up to date by Disconnect
+		uint32_t fBlockIndex : 31;
+		uint32_t fReclaim : 1; // handles hold a tombstone, not the body
+		uint32_t fSlotIndex : 30;
+		uint32_t fForward : 1; // forwards to another signal, see signal_impl::connect_signal
+		uint32_t fConnected : 1;
 
-		size_t fWeakRef;
-		size_t fStrongRef;
-		bool fConnected = true;
 
+		// counted by the allocation accounting
+		static void *operator new(size_t bytes) { return details::allocate(bytes); }
+		static void operator delete(void *p) { details::deallocate(p); }
+		static void *operator new(size_t, void *p) { return p; }
+		static void operator delete(void *, void *) { }
 
 		// we use linked as base class
 		// we wanna static_cast<linked_connection_body_base&>(node);
@@ -105,6 +544,11 @@ namespace tiss {
 		{
 			fWeakRef = 1;
 			fStrongRef = 1;
+			fBlockIndex = details::no_block;
+			fReclaim = false;
+			fSlotIndex = details::no_slot;
+			fForward = false;
+			fConnected = true;
 		}
 
 		void RemoveFromList()
@@ -117,6 +561,13 @@ namespace tiss {
 		{
 			if (fConnected) {
 				fConnected = false;
+				if (fOwner) {
+					fOwner->Disconnected(fSlotIndex);
+#if TISS_REGISTRY
+					details::bump(fOwner->fRecord->fLiveBytes, -(ptrdiff_t)BodySize());
+#endif
+				}
+				fSlotIndex = details::no_slot;
 				DecStrongRef();  // let signal give up the strong ref
 			}
 		}
@@ -134,7 +585,15 @@ namespace tiss {
 			if (fStrongRef == 0) {
 				// just image there is weak ref if fStrongRef > 0
 				RemoveFromList();
+				if (fOwner && fOwner->fDeferReclaim && Defer()) return;
 				Destroy();
+#if TISS_REGISTRY
+				if (fWeakRef > 1 && fOwner) {
+					// handles pin the memory, the slot index is free, keep the record there
+					details::registry().Pin(fOwner->fRecord, BodySize());
+					fSlotIndex = fOwner->fRecord->fId;
+				}
+#endif
 				DecWeakRef();
 			}
 		}
@@ -143,15 +602,250 @@ namespace tiss {
 			fWeakRef--;
 			if (fWeakRef == 0) {
 				// no strong ref and no weak ref
+#if TISS_REGISTRY
+				if (fStrongRef == 0 && fSlotIndex != details::no_slot) {
+					details::registry().Unpin(fSlotIndex, BodySize());
+				}
+#endif
 				DeleteThis();
 			}
 		}
 
-		void DeleteThis() {
-			delete this; // just free memory
-			             // because the derived class deconstructor will do nothing
-			             // Resource will be destroy by Desctroy
+		// a tombstone for the first handle of a reclaimable body, allocated alone
+		virtual details::tombstone *NewTombstone();
+
+		// the functor is gone, the handles will find no body in the tombstone
+		// the weak ref of the tombstone is dropped, so the memory goes with the last strong ref
+		inline void DetachTombstone(details::tombstone **slot);
+
+		// hand the body to the reclaim queue, false if someone else can still reach it
+		inline bool Defer();
+	};
+
+	namespace details {
+		struct tombstone_pool;
+
+		// shared by the connection handles of a reclaimable body
+		struct tombstone {
+			uint32_t fRef;
+			linked_connection_body_base *fBody; // null once the body is gone
+			tombstone_pool *fPool;              // null if allocated alone
+
+			static void *operator new(size_t bytes) { return allocate(bytes); }
+			static void operator delete(void *p) { deallocate(p); }
+		};
+
+		// the tombstones of an inline_signal, one per slot, in one block
+		// held by the signal and by every tombstone that has handles
+		struct tombstone_pool {
+			size_t fRefs;
+
+			static tombstone_pool *Create(size_t n) {
+				auto *pool = new(allocate(sizeof(tombstone_pool) + n * sizeof(tombstone))) tombstone_pool{ 1 };
+				for (size_t i = 0; i < n; ++i) ::new((void*)pool->At(i)) tombstone{ 0, nullptr, pool };
+				return pool;
+			}
+
+			tombstone *At(size_t i) {
+				return (tombstone*)(this + 1) + i;
+			}
+
+			void Release() {
+				if (--fRefs == 0) deallocate((void*)this);
+			}
+		};
+
+		// the tombstones of an inline_signal, the block is allocated for the first handle, not with the signal
+		// it can't be part of the signal, the handles may outlive it
+		struct inline_tombstones {
+			tombstone_pool *fPool = nullptr;
+			size_t fCount;
+
+			explicit inline_tombstones(size_t n) : fCount(n) { }
+
+			tombstone *At(size_t i) {
+				if (!fPool) fPool = tombstone_pool::Create(fCount);
+				return fPool->At(i);
+			}
+		};
+
+		template<bool Reclaim>
+		struct tombstone_holder {
+			tombstone **tombstone_slot() { return nullptr; }
+		};
+
+		template<>
+		struct tombstone_holder<true> {
+			tombstone *fTombstone = nullptr;
+			tombstone **tombstone_slot() { return &fTombstone; }
+		};
+
+		// the functor of signal_impl::connect_lazy
+		// keeps the constructor arguments, Obj is built in place on the first invocation
+		// the arguments and Obj share their storage, the arguments are destroyed once Obj is built
+		// a throwing constructor gives them their place back
+		template<class Obj, class... Stored>
+		struct lazy_slot {
+			using args_type = std::tuple<Stored...>;
+			bool fBuilt = false;
+			union {
+				args_type fArgs;
+				Obj fObj;
+			};
+
+			template<class... Args1>
+			explicit lazy_slot(Args1&&... args) : fArgs(std::forward<Args1>(args)...) { }
+			lazy_slot(lazy_slot const &) = delete;
+			lazy_slot &operator=(lazy_slot const &) = delete;
+
+			~lazy_slot() {
+				if (fBuilt) fObj.~Obj();
+				else fArgs.~args_type();
+			}
+
+			bool Materialize() {
+				if (fBuilt) return false;
+				Build(std::index_sequence_for<Stored...>());
+				return true;
+			}
+
+			template<size_t... I>
+			TISS_NOINLINE void Build(std::index_sequence<I...>) {
+				// Obj can't be built over the arguments it reads, they wait on the stack
+				args_type args(std::move(fArgs));
+				fArgs.~args_type();
+				try {
+					new((void*)&fObj) Obj(std::move(std::get<I>(args))...);
+				} catch (...) {
+					new((void*)&fArgs) args_type(std::move(args));
+					throw;
+				}
+				fBuilt = true;
+			}
+
+			template<class... Args1>
+			decltype(auto) operator()(Args1&&... args) {
+				if (!fBuilt) Build(std::index_sequence_for<Stored...>());
+				return fObj(std::forward<Args1>(args)...);
+			}
+		};
+
+		// the library's slots that reach single threaded state from their destructor say so
+		// with static const bool owner_thread_only = true
+		template<class FuncStorage, class = void>
+		struct owner_thread_only : std::false_type { };
+
+		template<class FuncStorage>
+		struct owner_thread_only<FuncStorage, std::enable_if_t<FuncStorage::owner_thread_only>> : std::true_type { };
+
+		// only lazy slots are built ahead, a user functor with a Materialize() member is left alone
+		template<class FuncStorage>
+		bool materialize(FuncStorage &) { return false; }
+		template<class Obj, class... Stored>
+		bool materialize(lazy_slot<Obj, Stored...> &f) { return f.Materialize(); }
+	}
+
+	inline details::tombstone *linked_connection_body_base::NewTombstone()
+	{
+		return new details::tombstone{ 0, this, nullptr };
+	}
+
+	inline void linked_connection_body_base::DetachTombstone(details::tombstone **slot)
+	{
+		if (slot && *slot) {
+			(*slot)->fBody = nullptr;
+			*slot = nullptr;
+			--fWeakRef; // the caller holds another one
+		}
+	}
+
+	// where the functor of a dead slot is destroyed
+	// immediate: by the last DecStrongRef, on the emitting thread if a slot is disconnected during emission
+	// deferred: by tiss::collect() or a reclaim_thread, the emitter only pushes the body to a lock-free queue
+	// a body is deferred only if nothing else sees it: allocated alone, with no handle pointing at it
+	// (handles of large functors point at a tombstone, so they don't count)
+	// a functor under TISS_RECLAIM_MIN_FUNCTOR bytes with a handle still held is destroyed immediately:
+	// the handle and the collector would both release the body, and its counts aren't atomic
+	// drop the handle before the slot dies, or lower TISS_RECLAIM_MIN_FUNCTOR, to have it deferred
+	// user functors, connect_lazy, connect_pure, queued and multicast slots may be deferred,
+	// the user functor's destructor must be fine on the collecting thread
+	// connect_signal, throttled, debounced and join slots touch state of the owning thread, they never are
+	enum class reclaim_policy {
+		immediate,
+		deferred,
+	};
+
+	namespace details {
+		// dead bodies linked by fNext, pushed by any thread
+		struct reclaim_stack {
+			std::atomic<linked_connection_body_base*> fHead{ nullptr };
+
+			void Push(linked_connection_body_base *body) {
+				auto *head = fHead.load(std::memory_order_relaxed);
+				do {
+					body->fNext = head;
+				} while (!fHead.compare_exchange_weak(head, body, std::memory_order_release, std::memory_order_relaxed));
+			}
+
+			linked_connection_body_base *TakeAll() {
+				return fHead.exchange(nullptr, std::memory_order_acquire);
+			}
+		};
+
+		inline reclaim_stack &reclaim_queue()
+		{
+			static reclaim_stack queue;
+			return queue;
+		}
+	}
+
+	inline bool linked_connection_body_base::Defer()
+	{
+		// connect_many blocks and inline_signal slots are freed by their owner
+		if (fBlockIndex != details::no_block || OwnerThreadOnly()) return false;
+		DetachTombstone(TombstoneSlot());
+		if (fWeakRef != 1) return false;
+		// the queue takes the weak ref of the list
+		details::reclaim_queue().Push(this);
+		return true;
+	}
+
+	// destroy the functors of the deferred bodies and free them, on the calling thread
+	// return the number of bodies freed
+	inline size_t collect()
+	{
+		size_t num = 0;
+		for (auto *body = details::reclaim_queue().TakeAll(); body; ++num) {
+			auto *next = static_cast<linked_connection_body_base*>(body->fNext);
+			body->Destroy();
+			body->DecWeakRef();
+			body = next;
+		}
+		return num;
+	}
+
+	// calls collect() every period on its own thread, and once more when it stops
+	class reclaim_thread {
+	public:
+		explicit reclaim_thread(std::chrono::microseconds period = std::chrono::milliseconds(1))
+			: fThread([this, period] {
+				while (!fStop.load(std::memory_order_acquire)) {
+					collect();
+					std::this_thread::sleep_for(period);
+				}
+				collect();
+			}) { }
+		reclaim_thread(reclaim_thread const &) = delete;
+		reclaim_thread &operator=(reclaim_thread const &) = delete;
+
+		~reclaim_thread() {
+			fStop.store(true, std::memory_order_release);
+			fThread.join();
 		}
+
+	private:
+		std::atomic<bool> fStop{ false };
+		std::thread fThread;
 	};
 
 	template<class Return, class... Args>
@@ -166,7 +860,8 @@ namespace tiss {
 	};
 
 	template<class FuncStorage, class Return, class... Args>
-	class connection_body_derived final : public connection_body<Return, Args...> {
+	class connection_body_derived : public connection_body<Return, Args...>,
+		private details::tombstone_holder<sizeof(FuncStorage) >= TISS_RECLAIM_MIN_FUNCTOR> {
 	public:
 		// memory layout
 		// vptr
@@ -174,16 +869,20 @@ namespace tiss {
 		// fNext
 		// fWeakRef
 		// fStrongRef
-		// fConnected
+		// fOwner
+		// fBlockIndex, fReclaim
+		// fSlotIndex, fForward, fConnected
+		// fTombstone, only if the functor is large
 		// fFuncStore
 
 		using connection_body_type = connection_body<Return, Args...>;
+		static const bool reclaim = sizeof(FuncStorage) >= TISS_RECLAIM_MIN_FUNCTOR;
 
 		union {// forbidden default constructor and deconstructor
 			FuncStorage fFuncStore;
 		};
 
-		connection_body_derived() { }
+		connection_body_derived() { this->fReclaim = reclaim; }
 		~connection_body_derived() { }
 
 
@@ -212,8 +911,90 @@ namespace tiss {
 		void Destroy() override final
 		{
 			fFuncStore.~FuncStorage();
+			if (this->fReclaim) this->DetachTombstone(TombstoneSlot());
+		}
+
+		details::tombstone **TombstoneSlot() override
+		{
+			return this->tombstone_slot();
+		}
+
+		bool Materialize() override final
+		{
+			return details::materialize(fFuncStore);
+		}
+
+		bool OwnerThreadOnly() const override final
+		{
+			return details::owner_thread_only<FuncStorage>::value;
+		}
+
+		void DeleteThis() override
+		{
+			// just free memory
+			// because the deconstructor will do nothing
+			// Resource will be destroy by Desctroy
+			if (this->fBlockIndex == details::no_block) {
+				// what delete does, inline_connection_body derives from us but never comes here
+				this->~connection_body_derived();
+				linked_connection_body_base::operator delete(this);
+			} else {
+				auto *block = block_of(this);
+				this->~connection_body_derived();
+				block->Release();
+			}
+		}
+
+		size_t BodySize() const override final
+		{
+			return sizeof(connection_body_derived);
+		}
+
+		// bodies in a block follow the header, which is padded to the alignment of the body
+		static size_t block_header_size()
+		{
+			return (sizeof(details::body_block) + alignof(connection_body_derived) - 1)
+				/ alignof(connection_body_derived) * alignof(connection_body_derived);
+		}
+
+		static details::body_block *block_of(connection_body_derived *body)
+		{
+			char *first = (char*)(body - body->fBlockIndex);
+			return (details::body_block*)(first - block_header_size());
+		}
+
+	};
+
+	// a body living in a slot of an inline_signal, the slot header precedes it
+	// its handles always go through the tombstone of the slot
+	template<class FuncStorage, class Return, class... Args>
+	class inline_connection_body final : public connection_body_derived<FuncStorage, Return, Args...> {
+	public:
+		inline_connection_body() {
+			this->fBlockIndex = details::inline_block;
+			this->fReclaim = true;
+		}
+
+		details::tombstone **TombstoneSlot() override final
+		{
+			return &details::inline_slot_of(this)->fTombstone;
 		}
 
+		details::tombstone *NewTombstone() override final
+		{
+			auto *header = details::inline_slot_of(this);
+			if (!header->fOwn) header->fOwn = header->fTombstones->At(header->fIndex);
+			header->fOwn->fBody = this;
+			++header->fOwn->fPool->fRefs;
+			return header->fOwn;
+		}
+
+		void DeleteThis() override final
+		{
+			auto *header = details::inline_slot_of(this);
+			this->~inline_connection_body();
+			header->fUsed = false;
+		}
 	};
 
 	namespace details {
@@ -234,97 +1015,1284 @@ namespace tiss {
 		using connection_type = connection;
 
 		// allow empty connection, so user can initialize connection later
-		// just we initialize fBody later
+		// just we initialize fHandle later
 		connection() {
-			fBody = nullptr;
+			fHandle = 0;
 		}
 
 		connection(connection const &r) {
-			if (r.fBody)
-				r.fBody->IncWeakRef();
-			fBody = r.fBody;
+			AddRef(r.fHandle);
+			fHandle = r.fHandle;
 		}
 
 		connection(connection &&r) {
-			fBody = r.fBody;
-			if (r.fBody)
-				r.fBody = nullptr;
+			fHandle = r.fHandle;
+			r.fHandle = 0;
 		}
 
 		connection &operator=(connection &&r)
 		{
 			// if this == &r
 			// there are at least 2 weak refs
-			if (fBody)
-				fBody->DecWeakRef();
-			fBody = r.fBody;
-			if (r.fBody)
-				r.fBody = nullptr;
+			Release(fHandle);
+			fHandle = r.fHandle;
+			r.fHandle = 0;
 			return *this;
 		}
 
 		connection &operator=(connection const &r) {
-			if (r.fBody)
-				r.fBody->IncWeakRef();
-			if (fBody)
-				fBody->DecWeakRef();
-			fBody = r.fBody;
+			AddRef(r.fHandle);
+			Release(fHandle);
+			fHandle = r.fHandle;
 			return *this;
 		}
 
-		connection(linked_connection_body_base *body) : fBody(body) {
-			fBody->IncWeakRef();
+		connection(linked_connection_body_base *body) {
+			if (!body->fReclaim) {
+				body->IncWeakRef();
+				fHandle = (uintptr_t)body;
+				return;
+			}
+			// the tombstone holds one weak ref for all the handles
+			details::tombstone **slot = body->TombstoneSlot();
+			if (!*slot) {
+				*slot = body->NewTombstone();
+				body->IncWeakRef();
+			}
+			++(*slot)->fRef;
+			fHandle = (uintptr_t)*slot | tombstone_bit;
 		}
 
 		~connection() {
-			if (fBody) {
-				fBody->DecWeakRef();
-				fBody = nullptr;
-			}
+			Release(fHandle);
+			fHandle = 0;
 		}
 
 		bool connected() {
-			return fBody && fBody->fConnected;
+			linked_connection_body_base *b = body();
+			return b && b->fConnected;
 		}
 
 		void disconnect() {
-			if (fBody) {
-				// try obtain the body
-				if (fBody->fStrongRef) {
-					fBody->Disconnect();
-					// body would not be deleted, becuase we have a weak ref
-					// but the functor may be destroied immediately
-				}
-				fBody->DecWeakRef();
-				fBody = nullptr;
+			TISS_ALLOC_PHASE(disconnect);
+			linked_connection_body_base *b = body();
+			// try obtain the body
+			if (b && b->fStrongRef) {
+				b->Disconnect();
+				// body would not be deleted, becuase we have a weak ref
+				// or, if reclaimable, it is already freed and the tombstone knows
 			}
+			Release(fHandle);
+			fHandle = 0;
 		}
 
-		linked_connection_body_base *fBody;
-	};
+		// the body, null if it is reclaimed
+		linked_connection_body_base *body() const {
+			if (fHandle & tombstone_bit)
+				return ((details::tombstone*)(fHandle & ~tombstone_bit))->fBody;
+			return (linked_connection_body_base*)fHandle;
+		}
 
-	template<class Result, class... Args>
-	struct signal_impl;
+		// a body pointer, or a tombstone pointer with the low bit set
+		uintptr_t fHandle;
 
+	private:
+		static const uintptr_t tombstone_bit = 1;
 
-	template<class Signature>
-	struct _Get_Tuple;
+		static void AddRef(uintptr_t h) {
+			if (h & tombstone_bit)
+				++((details::tombstone*)(h & ~tombstone_bit))->fRef;
+			else if (h)
+				((linked_connection_body_base*)h)->IncWeakRef();
+		}
 
-	template<class Return, class... Args>
-	struct _Get_Tuple< Return(Args...) >
-	{
-		using type = std::tuple< Args... >;
+		static void Release(uintptr_t h) {
+			if (h & tombstone_bit) {
+				auto *t = (details::tombstone*)(h & ~tombstone_bit);
+				if (--t->fRef == 0) {
+					if (t->fBody) {
+						*t->fBody->TombstoneSlot() = nullptr;
+						t->fBody->DecWeakRef();
+					}
+					if (t->fPool) t->fPool->Release();
+					else delete t;
+				}
+			} else if (h) {
+				((linked_connection_body_base*)h)->DecWeakRef();
+			}
+		}
 	};
 
-	template<class Result, class... Args>
-	class _Result_iterator_impl
-	{
-	public:
-		typedef Result _Signature(Args...);
-		using _Signal = signal_impl<Result, Args...>;
-		using _Node = details::linked;
-		using _Body = connection_body<Result, Args...>;
-		using _Tuple = std::tuple<Args...>;
+	// queued connections
+	// signal.connect(f, ctx) makes emission pack the arguments into a mailbox owned by ctx
+	// f runs later, on whatever thread calls ctx.pump()
+	// every queued connection has its own mailbox, so the messages of one connection are typed
+	// and a bounded mailbox needs no allocation per message
+	// messages of the same connection run in emission order
+	// the signal itself keeps the usual rule: connect/disconnect/emit of one signal from one thread at a time
+
+	enum class queue_policy {
+		block,        // emitter yields until the target thread makes room (backpressure)
+		              // the target thread can't wait for itself, it runs the oldest pending messages to make room
+		drop_newest,  // the new message is discarded
+		coalesce,     // the oldest pending message is discarded, the target sees the latest ones
+	};
+
+	struct queue_options {
+		size_t capacity = 0; // 0 means unbounded, otherwise rounded up to a power of two (at least 2)
+		queue_policy policy = queue_policy::block;
+	};
+
+	namespace details {
+
+		struct mpsc_node {
+			std::atomic<mpsc_node*> fNext{ nullptr };
+
+			// mailboxes and message nodes are counted by the allocation accounting
+			static void *operator new(size_t bytes) { return allocate(bytes); }
+			static void operator delete(void *p) { deallocate(p); }
+			static void *operator new(size_t, void *p) { return p; }
+			static void operator delete(void *, void *) { }
+		};
+
+		// Vyukov's intrusive multi-producer single-consumer queue
+		// push is wait-free, pop may report empty while a push is in progress
+		struct mpsc_queue {
+			std::atomic<mpsc_node*> fHead;
+			mpsc_node *fTail;
+			mpsc_node fStub;
+
+			mpsc_queue() : fHead(&fStub), fTail(&fStub) { }
+			mpsc_queue(mpsc_queue const &) = delete;
+			mpsc_queue &operator=(mpsc_queue const &) = delete;
+
+			void push(mpsc_node *n) {
+				n->fNext.store(nullptr, std::memory_order_relaxed);
+				mpsc_node *prev = fHead.exchange(n, std::memory_order_acq_rel);
+				prev->fNext.store(n, std::memory_order_release);
+			}
+
+			// consumer only
+			mpsc_node *pop() {
+				mpsc_node *tail = fTail;
+				mpsc_node *next = tail->fNext.load(std::memory_order_acquire);
+				if (tail == &fStub) {
+					if (!next) return nullptr;
+					fTail = next;
+					tail = next;
+					next = next->fNext.load(std::memory_order_acquire);
+				}
+				if (next) {
+					fTail = next;
+					return tail;
+				}
+				if (tail != fHead.load(std::memory_order_acquire)) return nullptr;
+				push(&fStub);
+				next = tail->fNext.load(std::memory_order_acquire);
+				if (next) {
+					fTail = next;
+					return tail;
+				}
+				return nullptr;
+			}
+		};
+
+		// Vyukov's bounded queue, a slot is claimed by a CAS on the position
+		// consumers may race too: the coalesce policy pops from the producer side
+		template<class T>
+		struct bounded_queue {
+			struct cell {
+				std::atomic<size_t> fSeq;
+				typename std::aligned_storage<sizeof(T), alignof(T)>::type fStore;
+			};
+
+			std::unique_ptr<cell[]> fCells;
+			size_t fMask;
+			std::atomic<size_t> fEnqueuePos{ 0 };
+			std::atomic<size_t> fDequeuePos{ 0 };
+
+			explicit bounded_queue(size_t capacity) {
+				size_t size = 2;
+				while (size < capacity) size *= 2;
+				note_library_alloc(sizeof(cell) * size);
+				fCells.reset(new cell[size]);
+				fMask = size - 1;
+				for (size_t i = 0; i < size; ++i) fCells[i].fSeq.store(i, std::memory_order_relaxed);
+			}
+
+			~bounded_queue() {
+				while (try_pop([](T &) { })) { }
+			}
+
+			template<class... Args1>
+			bool try_push(Args1&&... args) {
+				size_t pos = fEnqueuePos.load(std::memory_order_relaxed);
+				cell *c;
+				for (;;) {
+					c = &fCells[pos & fMask];
+					size_t seq = c->fSeq.load(std::memory_order_acquire);
+					intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+					if (dif == 0) {
+						if (fEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+					} else if (dif < 0) {
+						return false; // full
+					} else {
+						pos = fEnqueuePos.load(std::memory_order_relaxed);
+					}
+				}
+				new((void*)&c->fStore) T(std::forward<Args1>(args)...);
+				c->fSeq.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+
+			// f(T&) is called with the popped value before it is destroyed
+			template<class F>
+			bool try_pop(F&& f) {
+				size_t pos = fDequeuePos.load(std::memory_order_relaxed);
+				cell *c;
+				for (;;) {
+					c = &fCells[pos & fMask];
+					size_t seq = c->fSeq.load(std::memory_order_acquire);
+					intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+					if (dif == 0) {
+						if (fDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+					} else if (dif < 0) {
+						return false; // empty
+					} else {
+						pos = fDequeuePos.load(std::memory_order_relaxed);
+					}
+				}
+				T &v = reinterpret_cast<T&>(c->fStore);
+				f(v);
+				v.~T();
+				c->fSeq.store(pos + fMask + 1, std::memory_order_release);
+				return true;
+			}
+		};
+
+		// how an argument is held inside a mailbox
+		// values are copied (with the same copy_forward rule as direct emission)
+		// lvalue references stay references, the emitter must keep the object alive
+		template<class T>
+		struct queued_arg { using type = T; };
+		template<class T>
+		struct queued_arg<T&> { using type = T&; };
+		template<class T>
+		struct queued_arg<T&&> { using type = T; };
+
+		struct mailbox_base : mpsc_node {
+			std::atomic<size_t> fRefs{ 1 };
+			std::atomic<bool> fScheduled{ false };
+			std::atomic<bool> fAlive{ true };
+
+			virtual ~mailbox_base() { }
+			// run at most max messages, return the number of messages consumed
+			virtual size_t Drain(size_t max, bool &more) = 0;
+
+			void AddRef() { fRefs.fetch_add(1, std::memory_order_relaxed); }
+			void Release() {
+				if (fRefs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+			}
+		};
+	}
+
+	class thread_context
+	{
+	public:
+		thread_context() { }
+		thread_context(thread_context const &) = delete;
+		thread_context &operator=(thread_context const &) = delete;
+
+		~thread_context() {
+			// pending messages are dropped, not run
+			while (auto *n = fReady.pop()) {
+				static_cast<details::mailbox_base*>(n)->Release();
+			}
+		}
+
+		// run pending queued slots on the calling thread
+		// return the number of messages consumed
+		size_t pump(size_t max = size_t(-1))
+		{
+			fPumper.store(std::this_thread::get_id(), std::memory_order_relaxed);
+			size_t done = 0;
+			while (done < max) {
+				auto *n = fReady.pop();
+				if (!n) break;
+				auto *mb = static_cast<details::mailbox_base*>(n);
+				// clear first, a message posted while we drain will schedule again
+				mb->fScheduled.store(false, std::memory_order_seq_cst);
+				bool more = false;
+				done += mb->Drain(max - done, more);
+				if (more) Schedule(mb);
+				mb->Release();
+			}
+			return done;
+		}
+
+		// any thread
+		void Schedule(details::mailbox_base *mb)
+		{
+			if (!mb->fScheduled.exchange(true, std::memory_order_seq_cst)) {
+				mb->AddRef(); // the ready queue holds a ref
+				fReady.push(mb);
+			}
+		}
+
+		// true on the thread that pumps this context (the last one that called pump())
+		bool pumped_here() const {
+			return fPumper.load(std::memory_order_relaxed) == std::this_thread::get_id();
+		}
+
+	private:
+		details::mpsc_queue fReady;
+		std::atomic<std::thread::id> fPumper{ std::thread::id() };
+	};
+
+	namespace details {
+
+		template<class Func, class... Args>
+		struct mailbox final : mailbox_base {
+			using message_type = std::tuple<typename queued_arg<Args>::type...>;
+
+			struct message_node : mpsc_node {
+				message_type fMessage;
+				template<class... Args1>
+				message_node(Args1&&... args) : fMessage(std::forward<Args1>(args)...) { }
+			};
+
+			Func fFunc;
+			thread_context &fContext;
+			queue_options fOptions;
+			mpsc_queue fUnbounded;
+			std::unique_ptr<bounded_queue<message_type> > fBounded;
+
+			template<class Func1>
+			mailbox(Func1&& func, thread_context &ctx, queue_options opts)
+				: fFunc(std::forward<Func1>(func)), fContext(ctx), fOptions(opts)
+			{
+				if (opts.capacity) fBounded.reset(new bounded_queue<message_type>(opts.capacity));
+			}
+
+			~mailbox() {
+				while (auto *n = fUnbounded.pop()) delete static_cast<message_node*>(n);
+			}
+
+			// any thread
+			void Post(copy_forward_type<Args>... args)
+			{
+				if (!fBounded) {
+					fUnbounded.push(new message_node(copy_forward<Args>(args)...));
+				} else if (!fBounded->try_push(copy_forward<Args>(args)...)) {
+					switch (fOptions.policy) {
+					case queue_policy::block:
+						while (!fBounded->try_push(copy_forward<Args>(args)...)) {
+							if (!fContext.pumped_here()) {
+								std::this_thread::yield();
+								continue;
+							}
+							// nobody else will make room, waiting here would never end
+							bool more = false;
+							Drain(1, more);
+						}
+						break;
+					case queue_policy::drop_newest:
+						return;
+					case queue_policy::coalesce:
+						while (!fBounded->try_push(copy_forward<Args>(args)...)) {
+							fBounded->try_pop([](message_type &) { });
+						}
+						break;
+					}
+				}
+				fContext.Schedule(this);
+			}
+
+			template<std::size_t... I>
+			void Run(message_type &msg, std::index_sequence<I...>)
+			{
+				// the message is consumed once, so it is safe to move out of it
+				fFunc(std::forward<Args>(std::get<I>(msg))...);
+			}
+
+			size_t Drain(size_t max, bool &more) override
+			{
+				size_t done = 0;
+				bool alive = fAlive.load(std::memory_order_acquire);
+				for (; done < max; ++done) {
+					if (!fBounded) {
+						auto *n = static_cast<message_node*>(fUnbounded.pop());
+						if (!n) break;
+						if (alive) Run(n->fMessage, std::index_sequence_for<Args...>());
+						delete n;
+					} else {
+						// the message leaves the ring before it runs, a slot posting to itself finds the cell free
+						typename std::aligned_storage<sizeof(message_type), alignof(message_type)>::type store;
+						bool popped = fBounded->try_pop([&](message_type &msg) {
+							new((void*)&store) message_type(std::move(msg));
+						});
+						if (!popped) break;
+						auto &msg = reinterpret_cast<message_type&>(store);
+						if (alive) Run(msg, std::index_sequence_for<Args...>());
+						msg.~message_type();
+					}
+				}
+				more = done == max;
+				return done;
+			}
+		};
+
+		// the functor that sits in the signal's list for a queued connection
+		template<class Return, class Mailbox>
+		struct queued_slot {
+			Mailbox *fMailbox;
+
+			queued_slot(Mailbox *mb) : fMailbox(mb) { }
+			queued_slot(queued_slot &&r) : fMailbox(r.fMailbox) { r.fMailbox = nullptr; }
+			queued_slot(queued_slot const &) = delete;
+
+			~queued_slot() {
+				if (fMailbox) {
+					// pending messages of a disconnected slot are discarded
+					fMailbox->fAlive.store(false, std::memory_order_release);
+					fMailbox->Release();
+				}
+			}
+
+			template<class... Args1>
+			Return operator()(Args1&&... args) const
+			{
+				fMailbox->Post(std::forward<Args1>(args)...);
+				return Return();
+			}
+		};
+	}
+
+	// timed connections
+	// a throttled or debounced slot doesn't run on emission, the emission only keeps the latest arguments
+	// the slot runs later, from timer_wheel::tick(), called by the user's loop
+	// emission reads the time of the wheel, which moves only in tick(), so it never reads a clock
+	class timer_wheel;
+
+	namespace details {
+		struct wheel_timer : linked {
+			timer_wheel *fWheel;
+			uint64_t fDeadline = 0; // in ticks
+
+			wheel_timer(timer_wheel &wheel) : fWheel(&wheel) { }
+			virtual ~wheel_timer() { }
+			virtual void Fire() = 0;
+
+			bool Armed() { return fNext != this; }
+
+			void Unlink() {
+				fPrev->fNext = fNext;
+				fNext->fPrev = fPrev;
+				fPrev = this;
+				fNext = this;
+			}
+
+			// counted by the allocation accounting
+			static void *operator new(size_t bytes) { return allocate(bytes); }
+			static void operator delete(void *p) { deallocate(p); }
+		};
+	}
+
+	// hierarchical timer wheel: 4 levels of 64 slots, a timer sits in the level its distance falls in
+	// and moves down when the slot of the upper level comes round
+	// timers further than 64^4 ticks are parked at the end of the wheel and placed again when they come up
+	// one thread at a time, the same that emits the timed signals
+	class timer_wheel
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		explicit timer_wheel(clock::duration resolution = std::chrono::milliseconds(1),
+			clock::time_point start = clock::now())
+			: fResolution(resolution.count() > 0 ? resolution : clock::duration(1)), fStart(start) { }
+
+		timer_wheel(timer_wheel const &) = delete;
+		timer_wheel &operator=(timer_wheel const &) = delete;
+
+		// pending timers are dropped, the timed connections must not emit after this
+		~timer_wheel() {
+			for (auto &level : fSlots) {
+				for (auto &slot : level) {
+					while (!slot.empty()) static_cast<details::wheel_timer*>(slot.fNext)->Unlink();
+				}
+			}
+		}
+
+		// the time of the wheel in ticks, it only moves in tick() and advance()
+		uint64_t now() const { return fNow; }
+
+		// d in ticks, rounded up
+		uint64_t ticks(clock::duration d) const {
+			if (d.count() <= 0) return 0;
+			return (uint64_t)((d.count() + fResolution.count() - 1) / fResolution.count());
+		}
+
+		size_t num_timers() const { return fCount; }
+
+		// move the wheel to now and run the timers that are due
+		// return the number of timers fired
+		size_t tick(clock::time_point now = clock::now()) {
+			if (now <= fStart) return 0;
+			uint64_t target = (uint64_t)((now - fStart).count() / fResolution.count());
+			return target > fNow ? advance(target - fNow) : 0;
+		}
+
+		// move the wheel by n ticks
+		size_t advance(uint64_t n) {
+			size_t fired = 0;
+			uint64_t target = fNow + n;
+			while (fNow < target) {
+				if (fCount == 0) {
+					// nothing to cascade or fire
+					fNow = target;
+					break;
+				}
+				++fNow;
+				// move the upper levels down first, their slot may hold timers due now
+				for (int level = 1; level < levels; ++level) {
+					if ((fNow & ((uint64_t(1) << (level * level_bits)) - 1)) != 0) break;
+					Cascade(level);
+				}
+				fired += Expire(fSlots[0][fNow & slot_mask]);
+			}
+			return fired;
+		}
+
+		// run t at deadline (in ticks), at the next tick if the deadline has passed
+		void Schedule(details::wheel_timer *t, uint64_t deadline) {
+			if (t->Armed()) Cancel(t);
+			t->fDeadline = deadline;
+			Place(t);
+			++fCount;
+		}
+
+		void Cancel(details::wheel_timer *t) {
+			if (t->Armed()) {
+				t->Unlink();
+				--fCount;
+			}
+		}
+
+	private:
+		static const int level_bits = 6;
+		static const int levels = 4;
+		static const uint64_t slot_mask = (uint64_t(1) << level_bits) - 1;
+
+		clock::duration fResolution;
+		clock::time_point fStart;
+		uint64_t fNow = 0;
+		size_t fCount = 0;
+		details::linked fSlots[levels][uint64_t(1) << level_bits];
+
+		void Place(details::wheel_timer *t) {
+			uint64_t deadline = t->fDeadline > fNow ? t->fDeadline : fNow + 1;
+			uint64_t delta = deadline - fNow;
+			int level = 0;
+			while (level + 1 < levels && delta >= (uint64_t(1) << ((level + 1) * level_bits))) ++level;
+			if (delta >= (uint64_t(1) << (levels * level_bits))) {
+				// too far, park it at the end of the wheel
+				deadline = fNow + (uint64_t(1) << (levels * level_bits)) - 1;
+			}
+			fSlots[level][(deadline >> (level * level_bits)) & slot_mask].push_back(t);
+		}
+
+		void Cascade(int level) {
+			details::linked &slot = fSlots[level][(fNow >> (level * level_bits)) & slot_mask];
+			details::linked moved;
+			Take(slot, moved);
+			while (!moved.empty()) {
+				auto *t = static_cast<details::wheel_timer*>(moved.fNext);
+				t->Unlink();
+				// due on this very tick, Place() would push it to the next one
+				if (t->fDeadline <= fNow) fSlots[0][fNow & slot_mask].push_back(t);
+				else Place(t);
+			}
+		}
+
+		size_t Expire(details::linked &slot) {
+			if (slot.empty()) return 0;
+			// fired timers may schedule or cancel timers, work on a list of our own
+			details::linked due;
+			Take(slot, due);
+			size_t fired = 0;
+			while (!due.empty()) {
+				auto *t = static_cast<details::wheel_timer*>(due.fNext);
+				t->Unlink();
+				if (t->fDeadline > fNow) {
+					Place(t); // it was parked
+					continue;
+				}
+				--fCount;
+				t->Fire();
+				++fired;
+			}
+			return fired;
+		}
+
+		static void Take(details::linked &from, details::linked &to) {
+			if (from.empty()) return;
+			to.splice_back(from.fNext, from.fPrev);
+			from.fNext = &from;
+			from.fPrev = &from;
+		}
+	};
+
+	// the wheel used by connect_throttled and connect_debounced when none is given
+	inline timer_wheel &default_timer_wheel()
+	{
+		static timer_wheel wheel;
+		return wheel;
+	}
+
+	namespace details {
+
+		// the part of a throttled or debounced slot that the wheel reaches
+		// held by the slot and, while it runs, by the wheel, so the slot may disconnect itself
+		// the arguments are copied, references included, the emitter's objects are long gone when the slot runs
+		template<class Func, class... Args>
+		struct timed_state final : wheel_timer {
+			using message_type = std::tuple<std::decay_t<Args>...>;
+
+			Func fFunc;
+			uint64_t fInterval; // ticks, the period or the quiet time
+			uint64_t fLast = 0; // throttle: last run, debounce: last emission
+			bool fDebounce;
+			bool fHasRun = false;
+			bool fPending = false;
+			size_t fRefs = 1;
+			union {
+				message_type fArgs;
+			};
+
+			template<class Func1>
+			timed_state(Func1&& func, timer_wheel &wheel, uint64_t interval, bool debounce)
+				: wheel_timer(wheel), fFunc(std::forward<Func1>(func)), fInterval(interval), fDebounce(debounce) { }
+
+			~timed_state() {
+				if (fPending) fArgs.~message_type();
+			}
+
+			void Release() {
+				if (--fRefs == 0) delete this;
+			}
+
+			void Post(copy_forward_type<Args>... args) {
+				if (fPending) {
+					fArgs = message_type(copy_forward<Args>(args)...);
+				} else {
+					new((void*)&fArgs) message_type(copy_forward<Args>(args)...);
+					fPending = true;
+				}
+
+				uint64_t now = fWheel->now();
+				if (fDebounce) {
+					// the timer is not moved on every emission, Fire() looks at fLast
+					fLast = now;
+					if (!Armed()) fWheel->Schedule(this, now + fInterval);
+				} else if (!Armed()) {
+					fWheel->Schedule(this, fHasRun ? fLast + fInterval : now);
+				}
+			}
+
+			void Fire() override {
+				uint64_t now = fWheel->now();
+				if (fDebounce && now < fLast + fInterval) {
+					fWheel->Schedule(this, fLast + fInterval);
+					return;
+				}
+				if (!fPending) return;
+				fHasRun = true;
+				fLast = now;
+				message_type args(std::move(fArgs));
+				fArgs.~message_type();
+				fPending = false;
+				++fRefs;
+				Run(args, std::index_sequence_for<Args...>());
+				Release();
+			}
+
+			template<std::size_t... I>
+			void Run(message_type &msg, std::index_sequence<I...>) {
+				fFunc(std::forward<Args>(std::get<I>(msg))...);
+			}
+		};
+
+		// the functor that sits in the signal's list for a timed connection
+		template<class Return, class State>
+		struct timed_slot {
+			static const bool owner_thread_only = true; // cancels the timer of the wheel
+			State *fState;
+
+			timed_slot(State *state) : fState(state) { }
+			timed_slot(timed_slot &&r) : fState(r.fState) { r.fState = nullptr; }
+			timed_slot(timed_slot const &) = delete;
+
+			~timed_slot() {
+				if (fState) {
+					// pending arguments of a disconnected slot are dropped
+					if (fState->Armed()) fState->fWheel->Cancel(fState);
+					fState->Release();
+				}
+			}
+
+			template<class... Args1>
+			Return operator()(Args1&&... args) const
+			{
+				fState->Post(std::forward<Args1>(args)...);
+				return Return();
+			}
+		};
+	}
+
+	// hit/miss counters of a memoizing slot, see signal_impl::connect_pure
+	struct memo_stats {
+		size_t hits = 0;
+		size_t misses = 0;
+	};
+
+	namespace details {
+
+		struct no_hash { };
+
+		// remembers the last arguments and the last result of a pure functor
+		// if the arguments are equal to the last ones, the functor is not invoked
+		// with a user hash only the hash of the arguments is kept and compared
+		template<class Func, class Hash, class Return, class... Args>
+		class memo_slot {
+		public:
+			using key_type = std::conditional_t<std::is_same<Hash, no_hash>::value,
+				std::tuple<std::decay_t<Args>...>, size_t>;
+			using result_type = std::conditional_t<std::is_void<Return>::value, bool, Return>;
+
+			template<class Func1, class Hash1>
+			memo_slot(Func1&& func, Hash1&& hash, memo_stats *stats) :
+				fFunc(std::forward<Func1>(func)), fHash(std::forward<Hash1>(hash)), fStats(stats)
+			{
+			}
+
+			memo_slot(memo_slot const &) = delete;
+			memo_slot &operator=(memo_slot const &) = delete;
+
+			~memo_slot() {
+				if (fValid) {
+					fKey.~key_type();
+					fResult.~result_type();
+				}
+			}
+
+			Return operator()(copy_forward_type<Args>... args)
+			{
+				if (fValid && Match(std::is_same<Hash, no_hash>(), args...)) {
+					if (fStats) fStats->hits++;
+					return static_cast<Return>(fResult);
+				}
+				if (fStats) fStats->misses++;
+				return Call(std::is_void<Return>(), args...);
+			}
+
+		private:
+			Func fFunc;
+			Hash fHash;
+			memo_stats *fStats;
+			bool fValid = false;
+			union { key_type fKey; };
+			union { result_type fResult; };
+
+			bool Match(std::true_type, copy_forward_type<Args>... args) const
+			{
+				return fKey == std::forward_as_tuple(args...);
+			}
+
+			bool Match(std::false_type, copy_forward_type<Args>... args)
+			{
+				return fKey == static_cast<size_t>(fHash(args...));
+			}
+
+			// fKey is updated only after the functor returned
+			void SetKey(std::true_type, copy_forward_type<Args>... args)
+			{
+				if (fValid) fKey = std::forward_as_tuple(args...);
+				else new((void*)&fKey) key_type(args...);
+			}
+
+			void SetKey(std::false_type, copy_forward_type<Args>... args)
+			{
+				size_t h = fHash(args...);
+				if (fValid) fKey = h;
+				else new((void*)&fKey) key_type(h);
+			}
+
+			void Call(std::true_type, copy_forward_type<Args>... args)
+			{
+				fFunc(copy_forward<Args>(args)...);
+				SetKey(std::is_same<Hash, no_hash>(), args...);
+				if (!fValid) new((void*)&fResult) result_type(true);
+				fValid = true;
+			}
+
+			Return Call(std::false_type, copy_forward_type<Args>... args)
+			{
+				result_type r = fFunc(copy_forward<Args>(args)...);
+				SetKey(std::is_same<Hash, no_hash>(), args...);
+				if (fValid) fResult = std::move(r);
+				else new((void*)&fResult) result_type(std::move(r));
+				fValid = true;
+				return fResult;
+			}
+		};
+	}
+
+	// a connection handle that is just {index, generation} into the slot table of the signal
+	// trivially copyable, no ref counting, see signal_impl::connect_slot
+	// the handle is stale once the generation in the table moves on
+	struct slot_handle {
+		uint32_t fIndex;
+		uint32_t fGeneration;
+
+		slot_handle() : fIndex(details::no_slot), fGeneration(0) { }
+		slot_handle(uint32_t index, uint32_t generation) : fIndex(index), fGeneration(generation) { }
+
+		bool operator==(slot_handle const &r) const { return fIndex == r.fIndex && fGeneration == r.fGeneration; }
+		bool operator!=(slot_handle const &r) const { return !(*this == r); }
+	};
+
+	namespace details {
+		template<class MemFn>
+		struct member_of;
+
+		template<class R, class T, class... P>
+		struct member_of<R(T::*)(P...)> { using object = T; };
+
+		template<class R, class T, class... P>
+		struct member_of<R(T::*)(P...) const> { using object = T const; };
+	}
+
+	// one member function called on many objects, connected as one slot
+	// the objects are a plain array of pointers and F is a template argument,
+	// so emission is a loop of direct calls instead of an Invoke per object
+	// remove() is O(1), the last object moves into the hole, so the call order is not kept
+	// an object added while the multicast is running is called from the next emission on
+	// spell it member_multicast<decltype(&T::f), &T::f>, or member_multicast_of<&T::f> with C++17
+	template<class MemFn, MemFn F>
+	class member_multicast {
+	public:
+		using object_type = typename details::member_of<MemFn>::object;
+
+		member_multicast() { }
+		member_multicast(member_multicast const &) = delete;
+		member_multicast &operator=(member_multicast const &) = delete;
+
+		// the signals connected with connect_multicast let us go
+		~member_multicast() {
+			for (auto &con : fConnections) con.disconnect();
+		}
+
+		// the handle stays valid until remove(), whatever objects come and go
+		slot_handle add(object_type *obj) {
+			uint32_t key = fFreeKey;
+			if (key != details::no_slot) {
+				fFreeKey = fKeys[key].fNextFree;
+			} else {
+				key = (uint32_t)fKeys.size();
+				fKeys.push_back(key_entry{ 0, 0, details::no_slot });
+			}
+			fKeys[key].fPos = (uint32_t)fObjects.size();
+			fObjects.push_back(obj);
+			fKeyAt.push_back(key);
+			++fSize;
+			return slot_handle(key, fKeys[key].fGeneration);
+		}
+
+		bool contains(slot_handle h) const {
+			return h.fIndex < fKeys.size() && fKeys[h.fIndex].fGeneration == h.fGeneration;
+		}
+
+		void remove(slot_handle h) {
+			if (!contains(h)) return;
+			auto &e = fKeys[h.fIndex];
+			uint32_t pos = e.fPos;
+			++e.fGeneration;
+			e.fNextFree = fFreeKey;
+			fFreeKey = h.fIndex;
+			--fSize;
+			if (fRunning) {
+				// the loop is walking the array, leave a hole and close it afterwards
+				fObjects[pos] = nullptr;
+				fHoles = true;
+				return;
+			}
+			SwapRemove(pos);
+		}
+
+		size_t size() const { return fSize; }
+
+		template<class... Args1>
+		void operator()(Args1&&... args) {
+			++fRunning;
+			size_t n = fObjects.size();
+			for (size_t i = 0; i < n; ++i) {
+				object_type *obj = fObjects[i];
+				// copy before you forward, args are passed to every object
+				if (obj) (obj->*F)(args...);
+			}
+			if (--fRunning == 0 && fHoles) CloseHoles();
+		}
+
+		// used by signal_impl::connect_multicast
+		void AddConnection(connection con) {
+			fConnections.push_back(std::move(con));
+		}
+
+	private:
+		struct key_entry {
+			uint32_t fPos;
+			uint32_t fGeneration;
+			uint32_t fNextFree;
+		};
+
+		std::vector<object_type*> fObjects;
+		std::vector<uint32_t> fKeyAt; // key of the object at the same position
+		std::vector<key_entry> fKeys;
+		uint32_t fFreeKey = details::no_slot;
+		size_t fSize = 0;
+		int fRunning = 0;
+		bool fHoles = false;
+		std::vector<connection> fConnections;
+
+		void SwapRemove(uint32_t pos) {
+			uint32_t last = (uint32_t)fObjects.size() - 1;
+			if (pos != last) {
+				fObjects[pos] = fObjects[last];
+				fKeyAt[pos] = fKeyAt[last];
+				fKeys[fKeyAt[pos]].fPos = pos;
+			}
+			fObjects.pop_back();
+			fKeyAt.pop_back();
+		}
+
+		TISS_NOINLINE void CloseHoles() {
+			fHoles = false;
+			for (uint32_t pos = 0; pos < fObjects.size(); ) {
+				if (fObjects[pos]) ++pos;
+				else SwapRemove(pos);
+			}
+		}
+	};
+
+#if __cplusplus >= 201703L
+	template<auto F>
+	using member_multicast_of = member_multicast<decltype(F), F>;
+#endif
+
+	namespace details {
+		// the functors of signal_impl::connect<T, &T::f>(obj) and connect<&f>()
+		template<class T, class MemFn, MemFn F, class Return, class... Args>
+		struct member_binder {
+			T *fObj;
+
+			Return operator()(copy_forward_type<Args>... args) const
+			{
+				return (fObj->*F)(copy_forward<Args>(args)...);
+			}
+		};
+
+		template<class Fn, Fn F, class Return, class... Args>
+		struct function_binder {
+			Return operator()(copy_forward_type<Args>... args) const
+			{
+				return F(copy_forward<Args>(args)...);
+			}
+		};
+
+		// the functor that sits in the signal's list for a member_multicast
+		template<class Return, class Multicast>
+		struct multicast_slot {
+			Multicast *fMulticast;
+
+			template<class... Args1>
+			Return operator()(Args1&&... args) const
+			{
+				(*fMulticast)(std::forward<Args1>(args)...);
+				return Return();
+			}
+		};
+	}
+
+	// the part of a signal that doesn't depend on the signature
+	// list management, disconnection, counting and teardown are compiled once for all signals
+	// only connecting (the body type) and the invoke loops are left to signal_impl
+	class signal_base;
+
+	namespace details {
+		// a forwarding connection, kept in the list of the downstream signal
+		// so the downstream signal can cut it when it goes away
+		struct forward_link : linked {
+			signal_base *fTarget = nullptr;
+			linked_connection_body_base *fBody = nullptr;
+
+			void Unlink() {
+				fPrev->fNext = fNext;
+				fNext->fPrev = fPrev;
+				fPrev = this;
+				fNext = this;
+				fTarget = nullptr;
+			}
+		};
+
+		// the functor of a forwarding connection, see signal_impl::connect_signal
+		// signal_impl::operator() walks the target's slots inline and doesn't call it
+		// other emissions (emit_budgeted) go through here
+		template<class Signal, class... Args>
+		struct forward_slot {
+			static const bool owner_thread_only = true; // unlinks from the target signal
+			forward_link fLink;
+
+			forward_slot(signal_base *target, linked &upstreams) {
+				fLink.fTarget = target;
+				upstreams.push_back(&fLink);
+			}
+			forward_slot(forward_slot const &) = delete;
+
+			~forward_slot() {
+				if (fLink.fTarget) fLink.Unlink();
+			}
+
+			void operator()(copy_forward_type<Args>... args) const {
+				if (fLink.fTarget) (*static_cast<Signal*>(fLink.fTarget))(copy_forward<Args>(args)...);
+			}
+		};
+	}
+
+	class signal_base {
+	public:
+		using connection_bodies_type = details::linked;
+
+		connection_bodies_type fConnectionBodies;
+		details::signal_state fState;
+		details::linked fUpstreams; // forward_links of the signals forwarding to us
+
+		signal_base() {
+#if TISS_REGISTRY
+			fState.fRecord = details::registry().Add();
+#endif
+		}
+		signal_base(signal_base const &) = delete;
+		signal_base &operator=(signal_base const &) = delete;
+
+		signal_base(signal_base &&r) : signal_base() {
+			steal(r);
+		}
+
+		signal_base &operator=(signal_base &&r) {
+			if (this != &r) {
+				disconnect_all();
+				steal(r);
+			}
+			return *this;
+		}
+
+		~signal_base() {
+			disconnect_all();
+			disconnect_upstreams();
+#if TISS_REGISTRY
+			details::registry().SignalGone(fState.fRecord);
+#endif
+		}
+
+		// name shown by the registry, ignored without TISS_REGISTRY
+		void set_name(char const *name) {
+#if TISS_REGISTRY
+			std::lock_guard<std::mutex> lock(details::registry().fMutex);
+			fState.fRecord->fName = name;
+#else
+			(void)name;
+#endif
+		}
+
+		// take over the list of r
+		// the bodies point to our state now, O(n) but moving a signal is rare
+		TISS_NOINLINE void steal(signal_base &r) {
+			if (!r.fConnectionBodies.empty()) {
+				fConnectionBodies.fNext = r.fConnectionBodies.fNext;
+				fConnectionBodies.fPrev = r.fConnectionBodies.fPrev;
+				fConnectionBodies.fNext->fPrev = &fConnectionBodies;
+				fConnectionBodies.fPrev->fNext = &fConnectionBodies;
+				r.fConnectionBodies.fNext = &r.fConnectionBodies;
+				r.fConnectionBodies.fPrev = &r.fConnectionBodies;
+			}
+			auto *end = &fConnectionBodies;
+			for (auto p = fConnectionBodies.fNext; p != end; p = p->fNext) {
+				static_cast<linked_connection_body_base *>(p)->fOwner = &fState;
+			}
+			// the forwarding connections point to us now
+			disconnect_upstreams();
+			if (!r.fUpstreams.empty()) {
+				fUpstreams.splice_back(r.fUpstreams.fNext, r.fUpstreams.fPrev);
+				r.fUpstreams.fNext = &r.fUpstreams;
+				r.fUpstreams.fPrev = &r.fUpstreams;
+			}
+			for (auto p = fUpstreams.fNext; p != &fUpstreams; p = p->fNext) {
+				static_cast<details::forward_link *>(p)->fTarget = this;
+			}
+#if TISS_REGISTRY
+			// every signal keeps its own record, the counters follow the slots
+			auto *mine = fState.fRecord;
+			auto *theirs = r.fState.fRecord;
+			details::bump(mine->fLive, theirs->fLive.load(std::memory_order_relaxed));
+			details::bump(mine->fLiveBytes, theirs->fLiveBytes.load(std::memory_order_relaxed));
+			theirs->fLive.store(0, std::memory_order_relaxed);
+			theirs->fLiveBytes.store(0, std::memory_order_relaxed);
+#endif
+			fState = std::move(r.fState);
+			r.fState = details::signal_state();
+#if TISS_REGISTRY
+			fState.fRecord = mine;
+			r.fState.fRecord = theirs;
+#endif
+		}
+
+		void add_body(linked_connection_body_base *ptr) {
+			ptr->fOwner = &fState;
+			++fState.fNumConnections;
+#if TISS_REGISTRY
+			details::bump(fState.fRecord->fLive, 1);
+			details::bump(fState.fRecord->fLiveBytes, ptr->BodySize());
+#endif
+			fConnectionBodies.push_back(ptr);
+		}
+
+		// the handle doesn't keep a weak ref, the list owns the only one
+		TISS_NOINLINE slot_handle add_slot_body(linked_connection_body_base *ptr) {
+			add_body(ptr);
+			ptr->fSlotIndex = fState.AcquireSlot(ptr);
+			return slot_handle(ptr->fSlotIndex, fState.fSlots[ptr->fSlotIndex].fGeneration);
+		}
+
+		// append n bodies, first..last are linked already
+		TISS_NOINLINE void splice_bodies(details::linked *first, details::linked *last, size_t n) {
+			for (auto p = first; ; p = p->fNext) {
+				static_cast<linked_connection_body_base *>(p)->fOwner = &fState;
+#if TISS_REGISTRY
+				details::bump(fState.fRecord->fLive, 1);
+				details::bump(fState.fRecord->fLiveBytes, static_cast<linked_connection_body_base *>(p)->BodySize());
+#endif
+				if (p == last) break;
+			}
+			fState.fNumConnections += n;
+			fConnectionBodies.splice_back(first, last);
+		}
+
+		void disconnect_all_slots() { disconnect_all(); }
+
+		// cut the connections of the signals forwarding to us
+		TISS_NOINLINE void disconnect_upstreams()
+		{
+			TISS_ALLOC_PHASE(disconnect);
+			while (!fUpstreams.empty()) {
+				auto *link = static_cast<details::forward_link *>(fUpstreams.fNext);
+				// the body may be pinned by an emission, unlink now rather than on Destroy
+				link->Unlink();
+				link->fBody->Disconnect();
+			}
+		}
+
+		TISS_NOINLINE void disconnect_all()
+		{
+			TISS_ALLOC_PHASE(disconnect);
+			auto *end = &fConnectionBodies;
+			for (auto p = fConnectionBodies.fNext; p != end; )
+			{
+				// down cast
+				linked_connection_body_base &body = static_cast<linked_connection_body_base &>(*p);
+				p = p->fNext;
+				body.Disconnect();
+			}
+		}
+
+		size_t num_connections() const
+		{
+			return fState.fNumConnections;
+		}
+
+		// build the functors of the slots connected by connect_lazy now, return how many were built
+		size_t materialize_all()
+		{
+			size_t num = 0;
+			auto *end = &fConnectionBodies;
+			for (auto p = fConnectionBodies.fNext; p != end; )
+			{
+				// down cast
+				linked_connection_body_base &body = static_cast<linked_connection_body_base &>(*p);
+				if (!body.fConnected) {
+					p = p->fNext;
+					continue;
+				}
+				body.IncStrongRef(); // the constructor may disconnect
+				try {
+					num += body.Materialize();
+				} catch (...) {
+					body.DecStrongRef();
+					throw;
+				}
+				p = p->fNext;
+				body.DecStrongRef();
+			}
+			return num;
+		}
+
+		// see reclaim_policy, the bodies already dead are not affected
+		void set_reclaim_policy(reclaim_policy policy)
+		{
+			fState.fDeferReclaim = policy == reclaim_policy::deferred;
+		}
+
+		// number of emissions of this signal in progress, 1 inside a slot, > 1 when a slot emits it again
+		uint32_t emit_depth() const
+		{
+			return fState.fEmitDepth;
+		}
+
+		bool connected(slot_handle h) const
+		{
+			return h.fIndex < fState.fSlots.size() && fState.fSlots[h.fIndex].fGeneration == h.fGeneration;
+		}
+
+		void disconnect(slot_handle h)
+		{
+			TISS_ALLOC_PHASE(disconnect);
+			if (connected(h)) {
+				static_cast<linked_connection_body_base*>(fState.fSlots[h.fIndex].fBody)->Disconnect();
+			}
+		}
+	};
+
+	template<class Result, class... Args>
+	struct signal_impl;
+
+
+	template<class Signature>
+	struct _Get_Tuple;
+
+	template<class Return, class... Args>
+	struct _Get_Tuple< Return(Args...) >
+	{
+		using type = std::tuple< Args... >;
+	};
+
+	template<class Result, class... Args>
+	class _Result_iterator_impl
+	{
+	public:
+		typedef Result _Signature(Args...);
+		using _Signal = signal_impl<Result, Args...>;
+		using _Node = details::linked;
+		using _Body = connection_body<Result, Args...>;
+		using _Tuple = std::tuple<Args...>;
 
 		_Node *_fNode;
 		_Node const *_fHead;
@@ -337,427 +2305,2693 @@ namespace tiss {
 		{
 		}
 
-		//static_assert(std::is_copy_constructible_v<_Result_iterator_impl>);
-		//static_assert(std::is_copy_assignable_v<_Result_iterator_impl>);
+		//static_assert(std::is_copy_constructible_v<_Result_iterator_impl>);
+		//static_assert(std::is_copy_assignable_v<_Result_iterator_impl>);
+
+		bool operator!=(_Result_iterator_impl const &r) const
+		{
+			return _fNode != r._fNode;
+		}
+
+		_Result_iterator_impl &operator++()
+		{
+			_fNode = _fNode->fNext;
+			for (; _fNode != _fHead && !static_cast<_Body *>(_fNode)->fConnected; _fNode = _fNode->fNext) { }
+			return *this;
+		}
+
+		_Result_iterator_impl operator++(int)
+		{
+			_Result_iterator_impl t = *this;
+			++(*this);
+			return t;
+		}
+
+		template<std::size_t... I>
+		Result _Invoke(_Body &body, _Tuple *args, std::index_sequence<I...>) const
+		{
+			// make a copy and invoke
+			return body.Invoke(details::copy_forward<Args>(std::get<I>(*args))...);
+		}
+
+		Result operator*() const
+		{
+			TISS_ALLOC_PHASE(emit); // slots of a range run while it is iterated
+			auto &body = static_cast<_Body &>(*_fNode);
+			return _Invoke(body, _fArgs, std::make_index_sequence<sizeof...(Args)>());
+		}
+	};
+
+	template<class Signature>
+	struct _Get_result_iterator_impl;
+
+	template<class Return, class... Args>
+	struct _Get_result_iterator_impl<Return(Args...)> {
+		using type = _Result_iterator_impl<Return, Args...>;
+	};
+
+	template<class Signature>
+	struct result_iterator : _Get_result_iterator_impl<Signature>::type
+	{
+		using _MyBase = typename _Get_result_iterator_impl<Signature>::type;
+		using _Signal = typename _MyBase::_Signal;
+		using _Node = details::linked;
+		using _Body = typename _MyBase::_Body;
+		using _Tuple = typename _MyBase::_Tuple;
+
+		result_iterator(
+			_Node *node,
+			_Node const *head,
+			_Tuple *args) : _MyBase(node, head, args)
+		{
+		}
+	};
+
+	template<class Signature>
+	struct result_range
+	{
+		using _Tuple = typename _Get_Tuple<Signature>::type;
+		using _Iter = result_iterator<Signature>;
+		using _Node = details::linked;
+
+		_Tuple _fTuple;
+		_Iter _fBegin;
+		_Iter _fEnd;
+
+		template<class... Args1>
+		result_range(_Node *b, _Node const *e, Args1&&... args) :
+			_fTuple(std::forward<Args1>(args)...),
+			_fBegin(b, e, &_fTuple), 
+			_fEnd((_Node*)e, e, &_fTuple)
+		{
+		}
+
+		_Iter begin() const
+		{
+			return _fBegin;
+		}
+
+		_Iter end() const
+		{
+			return _fEnd;
+		}
+	};
+
+	// the state of an emission that ran out of time, see signal_impl::emit_budgeted
+	// holds a strong ref on the next node to invoke, like details::auto_lock,
+	// so the node stays in the list even if it is disconnected between slices
+	// the signal must outlive the cursor and must not be moved while the cursor is pending
+	template<class Signature>
+	class emit_cursor;
+
+	template<class Return, class... Args>
+	class emit_cursor<Return(Args...)>
+	{
+	public:
+		using connection_body_type = connection_body<Return, Args...>;
+		using _Tuple = std::tuple<Args...>;
+
+		// an exhausted cursor, to be assigned from emit_budgeted
+		emit_cursor() : fNode(nullptr) { }
+
+		template<class... Args1>
+		emit_cursor(connection_body_type *node, Args1&&... args) : fNode(node)
+		{
+			new((void*)&fArgs) _Tuple(std::forward<Args1>(args)...);
+			fHasArgs = true;
+		}
+
+		emit_cursor(emit_cursor &&r) : fNode(r.fNode) {
+			r.fNode = nullptr;
+			if (r.fHasArgs) {
+				new((void*)&fArgs) _Tuple(std::move(r.fArgs));
+				fHasArgs = true;
+			}
+		}
+
+		// the pending emission of this cursor is dropped, its node released
+		// the arguments are rebuilt, not assigned, a reference argument is rebound
+		emit_cursor &operator=(emit_cursor &&r) {
+			if (this != &r) {
+				Reset();
+				fNode = r.fNode;
+				r.fNode = nullptr;
+				if (r.fHasArgs) {
+					new((void*)&fArgs) _Tuple(std::move(r.fArgs));
+					fHasArgs = true;
+				}
+			}
+			return *this;
+		}
+
+		emit_cursor(emit_cursor const &) = delete;
+		emit_cursor &operator=(emit_cursor const &) = delete;
+
+		~emit_cursor() {
+			Reset();
+		}
+
+		bool done() const { return fNode == nullptr; }
+
+		connection_body_type *fNode;
+		union {
+			_Tuple fArgs;
+		};
+		bool fHasArgs = false;
+
+	private:
+		void Reset() {
+			if (fNode) fNode->DecStrongRef();
+			fNode = nullptr;
+			if (fHasArgs) fArgs.~_Tuple();
+			fHasArgs = false;
+		}
+	};
+
+	template<class Return, class... Args>
+	struct signal_impl : public signal_base {
+	public:
+		typedef Return Signature (Args...);
+		using Return_type = Return;
+		using connection_type = connection;
+		using connection_body_type = connection_body<Return, Args...>;
+		using forward_binder = details::forward_slot<signal_impl, Args...>;
+
+		signal_impl() {
+			register_signature();
+		};
+		signal_impl(signal_impl &&r) : signal_base(std::move(r)) {
+			register_signature();
+		}
+		signal_impl &operator=(signal_impl &&r) = default;
+
+		void register_signature() {
+#if TISS_REGISTRY
+			std::lock_guard<std::mutex> lock(details::registry().fMutex);
+			fState.fRecord->fSignature = details::demangle(typeid(Signature).name());
+#endif
+		}
+
+		//static_assert(std::is_move_assignable_v<signal>, "");
+		//static_assert(std::is_move_constructible_v<signal>, "");
+
+		template<class Func>
+		std::enable_if_t<
+			std::is_convertible<
+			    decltype(std::declval<Func>()
+			(std::declval<details::copy_forward_type<Args> >()...)),
+			    Return
+			>::value,
+			connection_type> connect(Func&& func)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = std::decay_t<Func>;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(std::forward<Func>(func));
+			add_body(ptr);
+			return ptr;
+		}
+
+		template<class Obj, class... Args1>
+		std::enable_if_t<
+			std::is_convertible<
+			    decltype(std::declval<Obj>()
+			        (std::declval<details::copy_forward_type<Args> >()...)),
+			    Return
+			>::value,
+			connection> connect_emplace(Args1&&... args)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = Obj;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(std::forward<Args1>(args)...);
+			add_body(ptr);
+			return ptr;
+		}
+
+		// like connect_emplace, but Obj is constructed on the first invocation, or by materialize_all
+		// only the decayed arguments are stored until then
+		template<class Obj, class... Args1>
+		std::enable_if_t<
+			std::is_convertible<
+			    decltype(std::declval<Obj&>()
+			        (std::declval<details::copy_forward_type<Args> >()...)),
+			    Return
+			>::value,
+			connection> connect_lazy(Args1&&... args)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = details::lazy_slot<Obj, std::decay_t<Args1>...>;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(std::forward<Args1>(args)...);
+			add_body(ptr);
+			return ptr;
+		}
+
+		// VS won't inline here
+		// it's not good, becuase there is only invocation point
+		template<class Func1, class... Args1>
+		auto connect_bind(Func1&& func, Args1&&... args)
+			-> std::enable_if_t<
+			std::is_convertible<
+			decltype(std::bind(std::forward<Func1>(func), std::forward<Args1>(args)...)
+			    (std::declval<details::copy_forward_type<Args> >()...)),
+			Return
+			>::value,
+			connection>
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = decltype(std::bind(std::forward<Func1>(func), std::forward<Args1>(args)...));
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize_bind(std::forward<Func1>(func), std::forward<Args1>(args)...);
+			add_body(ptr);
+			return ptr;
+		}
+
+		// static member function binding, the function is a template argument
+		// so the body keeps only obj and the call is inlined into Invoke
+		// s.connect<T, &T::f>(obj), s.connect<&T::f>(obj) with C++17, s.connect<&f>() for a free function
+		template<class T, Return(T::*F)(Args...)>
+		connection connect(T *obj)
+		{
+			return connect_bound(details::member_binder<T, Return(T::*)(Args...), F, Return, Args...>{ obj });
+		}
+
+		template<class T, Return(T::*F)(Args...) const>
+		connection connect(T const *obj)
+		{
+			return connect_bound(details::member_binder<T const, Return(T::*)(Args...) const, F, Return, Args...>{ obj });
+		}
+
+		template<Return(*F)(Args...)>
+		connection connect()
+		{
+			return connect_bound(details::function_binder<Return(*)(Args...), F, Return, Args...>());
+		}
+
+#if __cplusplus >= 201703L
+		template<auto F, class T>
+		connection connect(T *obj)
+		{
+			using Object = std::conditional_t<std::is_const<typename details::member_of<decltype(F)>::object>::value, T const, T>;
+			return connect_bound(details::member_binder<Object, decltype(F), F, Return, Args...>{ obj });
+		}
+#endif
+
+		template<class Binder>
+		connection connect_bound(Binder binder)
+		{
+			TISS_ALLOC_PHASE(connect);
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(binder);
+			add_body(ptr);
+			return ptr;
+		}
+
+		// runtime member pointers, the body keeps obj and funcptr
+		template<class T> 
+		connection connect_funcptr(T *obj, Return(T::*funcptr)(Args...))
+		{
+			TISS_ALLOC_PHASE(connect);
+			auto stub = [obj, funcptr](details::copy_forward_type<Args>... args)
+			{
+				return (obj->*funcptr)(details::copy_forward<Args>(args)...);
+			};
+			using Binder = decltype(stub);
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(stub);
+			add_body(ptr);
+			return ptr;
+		}
+
+		template<class T>
+		connection connect_funcptr(T *obj, Return(T::*funcptr)(Args...) const)
+		{
+			TISS_ALLOC_PHASE(connect);
+			auto stub = [obj, funcptr](details::copy_forward_type<Args>... args)
+			{
+				return (obj->*funcptr)(details::copy_forward<Args>(args)...);
+			};
+			using Binder = decltype(stub);
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(stub);
+			add_body(ptr);
+			return ptr;
+		}
+
+		template<class T>
+		connection connect_funcptr(T const *obj, Return(T::*funcptr)(Args...) const)
+		{
+			TISS_ALLOC_PHASE(connect);
+			auto stub = [obj, funcptr](details::copy_forward_type<Args>... args)
+			{
+				return (obj->*funcptr)(details::copy_forward<Args>(args)...);
+			};
+			using Binder = decltype(stub);
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(stub);
+			add_body(ptr);
+			return ptr;
+		}
+
+		connection connect_funcptr(Return(*funcptr)(Args...))
+		{
+			TISS_ALLOC_PHASE(connect);
+			// all things expaned! good!
+			using Binder = Return(*)(Args...);
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(funcptr);
+			add_body(ptr);
+			return ptr;
+		}
+
+		// connect every functor of range
+		// the bodies are allocated in one block and appended to the list in one splice
+		// return the number of connected slots
+		template<class Range>
+		size_t connect_many(Range&& range)
+		{
+			return connect_many(std::forward<Range>(range), details::discard_iterator());
+		}
+
+		// same as above, the connections are written to out
+		template<class Range, class OutIter>
+		size_t connect_many(Range&& range, OutIter out)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using std::begin;
+			using std::end;
+			using Binder = std::decay_t<decltype(*begin(range))>;
+			using Body = connection_body_derived<Binder, Return, Args...>;
+
+			size_t n = (size_t)std::distance(begin(range), end(range));
+			if (n == 0) return 0;
+			if (alignof(Body) > alignof(std::max_align_t) || n >= details::no_block) {
+				// ::operator new can't give the alignment, or the block is too large
+				for (auto &&func : range) *out++ = connect(func);
+				return n;
+			}
+
+			char *mem = (char*)details::allocate(Body::block_header_size() + n * sizeof(Body));
+			auto *block = new((void*)mem) details::body_block();
+			block->fLive = n;
+			Body *bodies = (Body*)(mem + Body::block_header_size());
+
+			size_t i = 0;
+			try {
+				for (auto &&func : range) {
+					Body *ptr = new((void*)(bodies + i)) Body();
+					ptr->fBlockIndex = (uint32_t)i;
+					ptr->initialize(func);
+					++i;
+				}
+			} catch (...) {
+				for (size_t j = 0; j < i; ++j) {
+					bodies[j].Destroy();
+					bodies[j].~Body();
+				}
+				details::deallocate((void*)mem);
+				throw;
+			}
+
+			for (size_t j = 0; j < n; ++j) {
+				bodies[j].fPrev = j ? &bodies[j - 1] : nullptr;
+				bodies[j].fNext = j + 1 < n ? &bodies[j + 1] : nullptr;
+			}
+			splice_bodies(&bodies[0], &bodies[n - 1], n);
+
+			for (size_t j = 0; j < n; ++j) *out++ = connection(&bodies[j]);
+			return n;
+		}
+
+		// connect func and return a slot_handle instead of a connection
+		// the handle holds no ref, so the body is freed right after disconnection
+		// use connected(handle) and disconnect(handle) of this signal
+		template<class Func>
+		slot_handle connect_slot(Func&& func)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = std::decay_t<Func>;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(std::forward<Func>(func));
+			return add_slot_body(ptr);
+		}
+
+		// memoizing connection, func must be a pure function of the arguments
+		// the last arguments and result are kept, emission with equal arguments returns the kept result
+		// arguments must be equality comparable
+		template<class Func>
+		connection connect_pure(Func&& func, memo_stats *stats = nullptr)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = details::memo_slot<std::decay_t<Func>, details::no_hash, Return, Args...>;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(std::forward<Func>(func), details::no_hash(), stats);
+			add_body(ptr);
+			return ptr;
+		}
+
+		// same as above, but only hash(args...) is kept and compared
+		// use it for large arguments, a hash collision returns a stale result
+		template<class Func, class Hash>
+		std::enable_if_t<
+			std::is_convertible<
+			    decltype(std::declval<Hash&>()
+			        (std::declval<details::copy_forward_type<Args> >()...)),
+			    size_t
+			>::value,
+			connection> connect_pure(Func&& func, Hash&& hash, memo_stats *stats = nullptr)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = details::memo_slot<std::decay_t<Func>, std::decay_t<Hash>, Return, Args...>;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(std::forward<Func>(func), std::forward<Hash>(hash), stats);
+			add_body(ptr);
+			return ptr;
+		}
+
+		// queued connection, func runs on the thread pumping ctx
+		// the result of a queued slot is not available to the emitter, Return() is returned instead
+		// ctx must outlive the connection
+		template<class Func>
+		connection connect(Func&& func, thread_context &ctx, queue_options opts = queue_options())
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Mailbox = details::mailbox<std::decay_t<Func>, Args...>;
+			using Binder = details::queued_slot<Return, Mailbox>;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(new Mailbox(std::forward<Func>(func), ctx, opts));
+			add_body(ptr);
+			return ptr;
+		}
+
+		// func runs at most once per period, from wheel.tick(), with the latest arguments
+		// the first emission after a quiet period runs on the next tick
+		// the result of a timed slot is not available to the emitter, Return() is returned instead
+		// wheel must outlive the connection
+		template<class Func>
+		connection connect_throttled(Func&& func, timer_wheel::clock::duration period,
+			timer_wheel &wheel = default_timer_wheel())
+		{
+			return connect_timed(std::forward<Func>(func), wheel, wheel.ticks(period), false);
+		}
+
+		// func runs, from wheel.tick(), with the latest arguments once there was no emission for quiet
+		template<class Func>
+		connection connect_debounced(Func&& func, timer_wheel::clock::duration quiet,
+			timer_wheel &wheel = default_timer_wheel())
+		{
+			return connect_timed(std::forward<Func>(func), wheel, wheel.ticks(quiet), true);
+		}
+
+		template<class Func>
+		connection connect_timed(Func&& func, timer_wheel &wheel, uint64_t interval, bool debounce)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using State = details::timed_state<std::decay_t<Func>, Args...>;
+			using Binder = details::timed_slot<Return, State>;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(new State(std::forward<Func>(func), wheel, interval, debounce));
+			add_body(ptr);
+			return ptr;
+		}
+
+		// relay every emission to other, a signal of the same signature
+		// operator() walks the slots of other in place, other's operator() isn't called
+		// the connection goes away when either signal does
+		template<class R = Return, class = std::enable_if_t<std::is_same<R, void>::value, void>>
+		connection connect_signal(signal_impl &other)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = forward_binder;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(&other, other.fUpstreams);
+			ptr->fFuncStore.fLink.fBody = ptr;
+			ptr->fForward = true;
+			add_body(ptr);
+			return ptr;
+		}
+
+		// call F of every object in mc, as one slot
+		// the connection is cut when mc is destroyed
+		template<class MemFn, MemFn F>
+		connection connect_multicast(member_multicast<MemFn, F> &mc)
+		{
+			TISS_ALLOC_PHASE(connect);
+			using Binder = details::multicast_slot<Return, member_multicast<MemFn, F> >;
+			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
+			ptr->initialize(Binder{ &mc });
+			add_body(ptr);
+			connection con(ptr);
+			mc.AddConnection(con);
+			return con;
+		}
+
+		// disconnect the slots for which pred(body) is true, in one walk
+		// return the number of disconnected slots
+		template<class Pred>
+		size_t disconnect_if(Pred&& pred)
+		{
+			TISS_ALLOC_PHASE(disconnect);
+			size_t num = 0;
+			auto *end = &fConnectionBodies;
+			for (auto p = fConnectionBodies.fNext; p != end; )
+			{
+				// down cast
+				connection_body_type &body = static_cast<connection_body_type &>(*p);
+				p = p->fNext;
+				if (body.fConnected && pred(static_cast<connection_body_type const &>(body))) {
+					body.Disconnect();
+					num += 1;
+				}
+			}
+			return num;
+		}
+
+		// VS won't inline here
+		// it's good, because there are many invocation points!
+		
+		void operator()(Args... args) const
+		{
+			TISS_ALLOC_PHASE(emit);
+			TISS_COUNT_EMIT(fState);
+			details::emit_scope scope(fState);
+			// copy before you forward
+			Walk(&fConnectionBodies, details::copy_forward<Args>(args)...);
+		}
+
+		// the slots of a forwarding connection are walked in place
+		// so a chain of relays costs one Invoke per final slot
+		static signal_base *forward_target(connection_body_type &body)
+		{
+			return static_cast<connection_body_derived<forward_binder, Return, Args...> &>(body).fFuncStore.fLink.fTarget;
+		}
+
+		// a disconnected body still in the list is locked by an outer emission
+		// it stays linked until that emission moves on, so step over it without a lock
+		static void Walk(details::linked const *end, details::copy_forward_type<Args>... args)
+		{
+			for (auto p = end->fNext; p != end; )
+			{
+				// down cast
+				connection_body_type &body = static_cast<connection_body_type &>(*p);
+
+				if (!body.fConnected) {
+					p = p->fNext;
+					continue;
+				}
+				details::auto_lock<Return, Args...> auto_lock(body);  //prevent unlink from list
+																	  // impossible inline
+				if (!body.fForward) {
+					body.Invoke(details::copy_forward<Args>(args)...);
+				} else if (signal_base *target = forward_target(body)) {
+					// the target emits, even if its operator() isn't called
+					TISS_COUNT_EMIT(target->fState);
+					details::emit_scope scope(target->fState);
+					Walk(&target->fConnectionBodies, details::copy_forward<Args>(args)...);
+				}
+				p = p->fNext;
+			}
+		}
+		
+
+		template<class R = Return, class = std::enable_if_t< !std::is_same<R, void>::value, void>>
+		bool emit_and_get_last_result(Args... args,
+				std::conditional_t<std::is_same<Return, void>::value, int, Return> &last) const
+		{
+			TISS_ALLOC_PHASE(emit);
+			TISS_COUNT_EMIT(fState);
+			details::emit_scope scope(fState);
+			auto const *end = &fConnectionBodies;
+			auto p = fConnectionBodies.fNext;
+
+			for (; p != end && !static_cast<connection_body_type*>(p)->fConnected; p = p->fNext) { }
+			if (p == end) return false;
+
+			for (;;)
+			{
+				connection_body_type &body = static_cast<connection_body_type &>(*p);
+
+				details::auto_lock<Return, Args...> auto_lock(body); //prevent unlink from list
+				auto tmp = body.Invoke(details::copy_forward<Args>(args)...);
+				p = p->fNext;     // get next
+
+				for (; p != end && !static_cast<connection_body_type*>(p)->fConnected; p = p->fNext) {}
+				if (p == end) {
+					last = std::move(tmp);
+					return false;
+				}
+
+			}
+		}
+
+		template<class R = Return, class = 
+			std::enable_if_t< 
+			    std::is_convertible<R, bool>::value
+		    >
+		>
+		bool emit_util_false(Args... args) const
+		{
+			TISS_ALLOC_PHASE(emit);
+			TISS_COUNT_EMIT(fState);
+			details::emit_scope scope(fState);
+			auto *end = &fConnectionBodies;
+			for (auto p = fConnectionBodies.fNext; p != end; )
+			{
+				// down cast
+				connection_body_type &body = static_cast<connection_body_type &>(*p);
+
+				if (!body.fConnected) {
+					p = p->fNext;
+					continue;
+				}
+				details::auto_lock<Return, Args...> auto_lock(body);  //prevent unlink from list
+																	  // impossible inline
+																	  // copy before you forward
+				bool v = body.Invoke(details::copy_forward<Args>(args)...);
+				if (v == false) return false;
+				p = p->fNext;
+			}
+			return true;
+		}
+
+		template<class R = Return, class =
+			std::enable_if_t<
+			std::is_convertible<R, bool>::value
+			>
+		>
+			bool emit_util_true(Args... args) const
+		{
+			TISS_ALLOC_PHASE(emit);
+			TISS_COUNT_EMIT(fState);
+			details::emit_scope scope(fState);
+			auto *end = &fConnectionBodies;
+			for (auto p = fConnectionBodies.fNext; p != end; )
+			{
+				// down cast
+				connection_body_type &body = static_cast<connection_body_type &>(*p);
+
+				if (!body.fConnected) {
+					p = p->fNext;
+					continue;
+				}
+				details::auto_lock<Return, Args...> auto_lock(body);  //prevent unlink from list
+																	  // impossible inline
+																	  // copy before you forward
+				bool v = body.Invoke(details::copy_forward<Args>(args)...);
+				if (v == true) return false;
+				p = p->fNext;
+			}
+			return true;
+		}
+
+
+		template<class ResultHanler, class = decltype(std::declval<ResultHanler&&>()(std::declval<Return>())) >
+		void operator()(Args... args,
+				ResultHanler&& handler) const
+		{
+			TISS_ALLOC_PHASE(emit);
+			TISS_COUNT_EMIT(fState);
+			details::emit_scope scope(fState);
+			auto *end = &fConnectionBodies;
+			for (auto p = fConnectionBodies.fNext; p != end; )
+			{
+				// down cast
+				connection_body_type &body = static_cast<connection_body_type &>(*p);
+
+				if (!body.fConnected) {
+					p = p->fNext;
+					continue;
+				}
+				details::auto_lock<Return, Args...> auto_lock(body);  //prevent unlink from list
+																	  // impossible inline
+				handler(body.Invoke(details::copy_forward<Args>(args)...));
+				p = p->fNext;
+			}
+		}
+
+		using emit_cursor_type = emit_cursor<Signature>;
+		using clock_type = std::chrono::steady_clock;
+
+		// invoke slots until the deadline passes, at least one slot is invoked
+		// the returned cursor holds a copy of the arguments, pass it to resume() on the next tick
+		// slots connected between slices are invoked, slots disconnected between slices are skipped
+		emit_cursor_type emit_budgeted(clock_type::time_point deadline, Args... args) const
+		{
+			TISS_ALLOC_PHASE(emit);
+			TISS_COUNT_EMIT(fState);
+			auto p = fConnectionBodies.fNext;
+			auto end = &fConnectionBodies;
+			for (; p != end && !static_cast<connection_body_type*>(p)->fConnected; p = p->fNext) {}
+
+			connection_body_type *first = nullptr;
+			if (p != end) {
+				first = static_cast<connection_body_type*>(p);
+				first->IncStrongRef();
+			}
+			// move if possible
+			emit_cursor_type cursor(first, std::forward<Args>(args)...);
+			resume(cursor, deadline);
+			return cursor;
+		}
+
+		// continue an emission started by emit_budgeted
+		// return true if all slots have been invoked
+		bool resume(emit_cursor_type &cursor, clock_type::time_point deadline) const
+		{
+			TISS_ALLOC_PHASE(emit);
+			auto const *end = &fConnectionBodies;
+			while (cursor.fNode) {
+				connection_body_type &body = *cursor.fNode;
+				if (body.fConnected) {
+					_Invoke_tuple(body, cursor.fArgs, std::index_sequence_for<Args...>());
+				}
+
+				// we own a strong ref, so body is still linked
+				auto next = body.fNext;
+				for (; next != end && !static_cast<connection_body_type*>(next)->fConnected; next = next->fNext) {}
+				if (next == end) {
+					cursor.fNode = nullptr;
+				} else {
+					cursor.fNode = static_cast<connection_body_type*>(next);
+					cursor.fNode->IncStrongRef();
+				}
+				body.DecStrongRef();
+
+				if (cursor.fNode && clock_type::now() >= deadline) return false;
+			}
+			return true;
+		}
+
+		template<std::size_t... I>
+		static Return _Invoke_tuple(connection_body_type &body, std::tuple<Args...> &args, std::index_sequence<I...>)
+		{
+			// make a copy and invoke
+			return body.Invoke(details::copy_forward<Args>(std::get<I>(args))...);
+		}
+
+		result_range<Signature> emit_and_get_range(Args... args) const
+		{
+			TISS_ALLOC_PHASE(emit);
+			TISS_COUNT_EMIT(fState);
+			auto p = fConnectionBodies.fNext;
+			auto end = &fConnectionBodies;
+			for (; p != end && !static_cast<connection_body_type*>(p)->fConnected; p = p->fNext) {}
+
+			// move if possible
+			return result_range<Signature>(p, end, std::forward<Args>(args)...);
+		}
+
+	};
+
+	template<class Signature>
+	struct get_signal_impl;
+
+	template<class Return, class... Args>
+	struct get_signal_impl<Return(Args...)> {
+		using type = signal_impl<Return, Args...>;
+	};
+
+	template<class Signature>
+	class signal : public get_signal_impl<Signature>::type
+	{
+	public:
+		using base_type = typename get_signal_impl<Signature>::type;
+		signal() : base_type() { }
+		signal(signal&& r) : base_type(std::move((base_type&&)r)) { }
+		signal& operator=(signal&& r) { (base_type&)(*this) = std::move((base_type&&)r); return *this; }
+	};
+
+	// a signal keeping up to N slot bodies in itself, connect, disconnect and emit never allocate
+	// a functor takes at most MaxFunctor bytes, a bigger one doesn't compile
+	// connect returns an empty connection when all the slots are taken
+	// the bodies live in the signal, so it can't be moved
+	// the handles go through tombstones, allocated in one block by the first connect,
+	// so a connection may outlive the signal like with signal, it is disconnected then
+	// constructing the signal doesn't allocate, the block can't be part of it since the handles outlive it
+	template<class Signature, size_t N, size_t MaxFunctor = 4 * sizeof(void*)>
+	class inline_signal;
+
+	template<class Return, class... Args, size_t N, size_t MaxFunctor>
+	class inline_signal<Return(Args...), N, MaxFunctor> : private signal_impl<Return, Args...>
+	{
+	public:
+		using base_type = signal_impl<Return, Args...>;
+		using typename base_type::connection_type;
+		using typename base_type::emit_cursor_type;
+		using typename base_type::clock_type;
+
+		static const size_t capacity = N;
+		static const size_t slot_size = details::inline_header_size +
+			(sizeof(linked_connection_body_base) + MaxFunctor + alignof(std::max_align_t) - 1)
+			/ alignof(std::max_align_t) * alignof(std::max_align_t);
+
+		inline_signal() : fTombstones(N) {
+			for (size_t i = 0; i < N; ++i) {
+				auto *header = Header(i);
+				header->fTombstone = nullptr;
+				header->fOwn = nullptr;
+				header->fTombstones = &fTombstones;
+				header->fIndex = i;
+				header->fUsed = false;
+			}
+		}
+		inline_signal(inline_signal const &) = delete;
+		inline_signal &operator=(inline_signal const &) = delete;
+
+		~inline_signal() {
+			// the bodies go, the tombstones stay with the handles
+			this->disconnect_all();
+			if (fTombstones.fPool) fTombstones.fPool->Release();
+		}
+
+		using base_type::operator();
+		using base_type::emit_and_get_last_result;
+		using base_type::emit_util_false;
+		using base_type::emit_util_true;
+		using base_type::emit_budgeted;
+		using base_type::resume;
+		using base_type::emit_and_get_range;
+		using base_type::disconnect_if;
+		using base_type::disconnect_all;
+		using base_type::num_connections;
+		using base_type::emit_depth;
+		using base_type::set_name;
+
+		// slots not taken, a slot is held until the last connection to its body goes
+		size_t free_slots() const {
+			size_t num = 0;
+			for (size_t i = 0; i < N; ++i) num += Free(Header(i));
+			return num;
+		}
+
+		template<class Func>
+		std::enable_if_t<
+			std::is_convertible<
+			    decltype(std::declval<Func>()
+			(std::declval<details::copy_forward_type<Args> >()...)),
+			    Return
+			>::value,
+			connection_type> connect(Func&& func)
+		{
+			return Emplace<std::decay_t<Func>>(std::forward<Func>(func));
+		}
+
+		template<class Obj, class... Args1>
+		std::enable_if_t<
+			std::is_convertible<
+			    decltype(std::declval<Obj>()
+			        (std::declval<details::copy_forward_type<Args> >()...)),
+			    Return
+			>::value,
+			connection> connect_emplace(Args1&&... args)
+		{
+			return Emplace<Obj>(std::forward<Args1>(args)...);
+		}
+
+		template<class T, Return(T::*F)(Args...)>
+		connection connect(T *obj)
+		{
+			using Binder = details::member_binder<T, Return(T::*)(Args...), F, Return, Args...>;
+			return Emplace<Binder>(Binder{ obj });
+		}
+
+		template<class T, Return(T::*F)(Args...) const>
+		connection connect(T const *obj)
+		{
+			using Binder = details::member_binder<T const, Return(T::*)(Args...) const, F, Return, Args...>;
+			return Emplace<Binder>(Binder{ obj });
+		}
+
+		template<Return(*F)(Args...)>
+		connection connect()
+		{
+			return Emplace<details::function_binder<Return(*)(Args...), F, Return, Args...>>();
+		}
+
+#if __cplusplus >= 201703L
+		template<auto F, class T>
+		connection connect(T *obj)
+		{
+			using Object = std::conditional_t<std::is_const<typename details::member_of<decltype(F)>::object>::value, T const, T>;
+			using Binder = details::member_binder<Object, decltype(F), F, Return, Args...>;
+			return Emplace<Binder>(Binder{ obj });
+		}
+#endif
+
+		connection connect_funcptr(Return(*funcptr)(Args...))
+		{
+			return Emplace<Return(*)(Args...)>(funcptr);
+		}
+
+	private:
+		alignas(std::max_align_t) unsigned char fStorage[N * slot_size];
+		details::inline_tombstones fTombstones;
+
+		details::inline_slot_header *Header(size_t i) const {
+			return (details::inline_slot_header*)(fStorage + i * slot_size);
+		}
+
+		static bool Free(details::inline_slot_header const *header) {
+			return !header->fUsed && (!header->fOwn || header->fOwn->fRef == 0);
+		}
+
+		template<class Binder, class... Args1>
+		connection Emplace(Args1&&... args)
+		{
+			using body_type = inline_connection_body<Binder, Return, Args...>;
+			static_assert(details::inline_header_size + sizeof(body_type) <= slot_size,
+				"the functor is larger than MaxFunctor");
+			static_assert(alignof(body_type) <= alignof(std::max_align_t), "the functor is over aligned");
+			TISS_ALLOC_PHASE(connect);
+			for (size_t i = 0; i < N; ++i) {
+				auto *header = Header(i);
+				if (!Free(header)) continue;
+				header->fUsed = true;
+				body_type *ptr = new((void*)((char*)header + details::inline_header_size)) body_type();
+				ptr->initialize(std::forward<Args1>(args)...);
+				this->add_body(ptr);
+				return ptr;
+			}
+			return connection();
+		}
+	};
+
+	// operator pipelines
+	// signal | filter(p) | map(f) | take(n) | connect(sink)
+	// the stages are fused at compile time into one functor, stored in one connection body
+	// so an event costs one Invoke no matter how many stages there are
+	namespace details {
+
+		struct pipe_op { };
+
+		template<class Pred, class Next>
+		struct filter_stage {
+			Pred fPred;
+			Next fNext;
+			template<class... A>
+			void operator()(A&&... args) {
+				if (fPred(args...)) fNext(std::forward<A>(args)...);
+			}
+		};
+
+		template<class Func, class Next>
+		struct map_stage {
+			Func fFunc;
+			Next fNext;
+			template<class... A>
+			void operator()(A&&... args) {
+				fNext(fFunc(std::forward<A>(args)...));
+			}
+		};
+
+		template<class Next>
+		struct take_stage {
+			size_t fLeft;
+			Next fNext;
+			template<class... A>
+			void operator()(A&&... args) {
+				if (fLeft) {
+					--fLeft;
+					fNext(std::forward<A>(args)...);
+				}
+			}
+		};
+
+		template<class Pred>
+		struct filter_op : pipe_op {
+			Pred fPred;
+			template<class Pred1>
+			explicit filter_op(Pred1&& pred) : fPred(std::forward<Pred1>(pred)) { }
+			template<class Next>
+			filter_stage<Pred, std::decay_t<Next> > bind(Next&& next) {
+				return { std::move(fPred), std::forward<Next>(next) };
+			}
+		};
+
+		template<class Func>
+		struct map_op : pipe_op {
+			Func fFunc;
+			template<class Func1>
+			explicit map_op(Func1&& func) : fFunc(std::forward<Func1>(func)) { }
+			template<class Next>
+			map_stage<Func, std::decay_t<Next> > bind(Next&& next) {
+				return { std::move(fFunc), std::forward<Next>(next) };
+			}
+		};
+
+		struct take_op : pipe_op {
+			size_t fCount;
+			explicit take_op(size_t count) : fCount(count) { }
+			template<class Next>
+			take_stage<std::decay_t<Next> > bind(Next&& next) {
+				return { fCount, std::forward<Next>(next) };
+			}
+		};
+
+		template<class Sink>
+		struct connect_op {
+			Sink fSink;
+		};
+
+		// the functor in the connection body, the fused stages return nothing
+		template<class Return, class Fused>
+		struct pipeline_slot {
+			Fused fFused;
+			template<class... A>
+			Return operator()(A&&... args) {
+				fFused(std::forward<A>(args)...);
+				return Return();
+			}
+		};
+
+		template<class Signal, class... Ops>
+		struct pipeline {
+			Signal &fSignal;
+			std::tuple<Ops...> fOps;
+
+			template<class Next>
+			static Next &&fuse(std::tuple<Ops...> &, Next &&next, std::integral_constant<size_t, 0>) {
+				return std::forward<Next>(next);
+			}
+
+			// bind from the last op to the first one
+			template<class Next, size_t I>
+			static auto fuse(std::tuple<Ops...> &ops, Next &&next, std::integral_constant<size_t, I>) {
+				return fuse(ops, std::get<I - 1>(ops).bind(std::forward<Next>(next)),
+					std::integral_constant<size_t, I - 1>());
+			}
+		};
+	}
+
+	template<class Pred>
+	details::filter_op<std::decay_t<Pred> > filter(Pred&& pred)
+	{
+		return details::filter_op<std::decay_t<Pred> >(std::forward<Pred>(pred));
+	}
+
+	template<class Func>
+	details::map_op<std::decay_t<Func> > map(Func&& func)
+	{
+		return details::map_op<std::decay_t<Func> >(std::forward<Func>(func));
+	}
+
+	inline details::take_op take(size_t count)
+	{
+		return details::take_op(count);
+	}
+
+	template<class Sink>
+	details::connect_op<std::decay_t<Sink> > connect(Sink&& sink)
+	{
+		return { std::forward<Sink>(sink) };
+	}
+
+	template<class Return, class... Args, class Op,
+		class = std::enable_if_t<std::is_base_of<details::pipe_op, std::decay_t<Op> >::value> >
+	details::pipeline<signal_impl<Return, Args...>, std::decay_t<Op> >
+	operator|(signal_impl<Return, Args...> &sig, Op&& op)
+	{
+		return { sig, std::make_tuple(std::forward<Op>(op)) };
+	}
+
+	template<class Signal, class... Ops, class Op,
+		class = std::enable_if_t<std::is_base_of<details::pipe_op, std::decay_t<Op> >::value> >
+	details::pipeline<Signal, Ops..., std::decay_t<Op> >
+	operator|(details::pipeline<Signal, Ops...> &&pipe, Op&& op)
+	{
+		return { pipe.fSignal, std::tuple_cat(std::move(pipe.fOps), std::make_tuple(std::forward<Op>(op))) };
+	}
+
+	template<class Signal, class... Ops, class Sink>
+	connection operator|(details::pipeline<Signal, Ops...> &&pipe, details::connect_op<Sink> &&op)
+	{
+		using Pipe = details::pipeline<Signal, Ops...>;
+		auto fused = Pipe::fuse(pipe.fOps, std::move(op.fSink), std::integral_constant<size_t, sizeof...(Ops)>());
+		using Binder = details::pipeline_slot<typename Signal::Return_type, decltype(fused)>;
+		return pipe.fSignal.template connect_emplace<Binder>(Binder{ std::move(fused) });
+	}
+
+	template<class Return, class... Args, class Sink>
+	connection operator|(signal_impl<Return, Args...> &sig, details::connect_op<Sink> &&op)
+	{
+		return sig.connect(std::move(op.fSink));
+	}
+
+	// the default projection of keyed_signal, the key is the first argument
+	struct first_arg_key {
+		template<class First, class... Rest>
+		First const &operator()(First const &first, Rest const &...) const { return first; }
+	};
+
+	// keyed_signal routes an emission to the slots connected with the key of the arguments
+	// the key is computed by KeyOf(args...), an open addressing table maps key to its own signal_impl
+	// so an emission only walks the matching slots (plus the catch-all slots), not all slots
+	template<class Key, class Signature, class KeyOf = first_arg_key, class Hash = std::hash<Key> >
+	class keyed_signal;
+
+	template<class Key, class Return, class... Args, class KeyOf, class Hash>
+	class keyed_signal<Key, Return(Args...), KeyOf, Hash>
+	{
+	public:
+		using signal_type = signal_impl<Return, Args...>;
+
+		keyed_signal(KeyOf key_of = KeyOf(), Hash hash = Hash()) : fKeyOf(key_of), fHash(hash) { }
+		keyed_signal(keyed_signal const &) = delete;
+		keyed_signal &operator=(keyed_signal const &) = delete;
+
+		template<class Func>
+		connection connect(Key const &key, Func&& func)
+		{
+			return get_or_add(key).connect(std::forward<Func>(func));
+		}
+
+		template<class Obj, class... Args1>
+		connection connect_emplace(Key const &key, Args1&&... args)
+		{
+			return get_or_add(key).template connect_emplace<Obj>(std::forward<Args1>(args)...);
+		}
+
+		// catch-all slot, invoked for every key after the keyed slots
+		template<class Func>
+		connection connect_all(Func&& func)
+		{
+			return fAll.connect(std::forward<Func>(func));
+		}
+
+		void operator()(Args... args) const
+		{
+			signal_type *sig = find(fKeyOf(details::copy_forward<Args>(args)...));
+			// copy before you forward
+			if (sig) (*sig)(details::copy_forward<Args>(args)...);
+			fAll(details::copy_forward<Args>(args)...);
+		}
+
+		size_t num_keys() const { return fSize; }
+
+		size_t num_connections(Key const &key) const
+		{
+			signal_type *sig = find(key);
+			return sig ? sig->num_connections() : 0;
+		}
+
+		void disconnect_all()
+		{
+			for (auto &e : fTable) if (e.fSignal) e.fSignal->disconnect_all();
+			fAll.disconnect_all();
+		}
+
+		// drop the keys that have no connected slot left
+		void compact()
+		{
+			std::vector<entry> old;
+			old.swap(fTable);
+			fTable.resize(old.size());
+			fSize = 0;
+			for (auto &e : old) {
+				if (e.fSignal && e.fSignal->num_connections()) insert(std::move(e));
+			}
+		}
+
+	private:
+		struct entry {
+			Key fKey;
+			std::unique_ptr<signal_type> fSignal; // null means the bucket is empty
+		};
+
+		KeyOf fKeyOf;
+		Hash fHash;
+		std::vector<entry> fTable; // size is zero or a power of two
+		size_t fSize = 0;
+		signal_type fAll;
+
+		size_t bucket(Key const &key) const
+		{
+			// spread the bits, std::hash of integers is often the identity
+			size_t h = fHash(key) * static_cast<size_t>(0x9E3779B97F4A7C15ull);
+			return (h ^ (h >> (sizeof(size_t) * 4))) & (fTable.size() - 1);
+		}
+
+		signal_type *find(Key const &key) const
+		{
+			if (fTable.empty()) return nullptr;
+			size_t mask = fTable.size() - 1;
+			for (size_t i = bucket(key); ; i = (i + 1) & mask) {
+				auto &e = fTable[i];
+				if (!e.fSignal) return nullptr;
+				if (e.fKey == key) return e.fSignal.get();
+			}
+		}
+
+		signal_type &insert(entry &&e)
+		{
+			size_t mask = fTable.size() - 1;
+			size_t i = bucket(e.fKey);
+			for (; fTable[i].fSignal; i = (i + 1) & mask) { }
+			fTable[i] = std::move(e);
+			++fSize;
+			return *fTable[i].fSignal;
+		}
+
+		signal_type &get_or_add(Key const &key)
+		{
+			if (signal_type *sig = find(key)) return *sig;
+			// keep the load factor under 1/2, probes stay short
+			if ((fSize + 1) * 2 > fTable.size()) {
+				std::vector<entry> old;
+				old.swap(fTable);
+				fTable.resize(old.empty() ? 16 : old.size() * 2);
+				fSize = 0;
+				for (auto &e : old) if (e.fSignal) insert(std::move(e));
+			}
+			return insert(entry{ key, std::unique_ptr<signal_type>(new signal_type()) });
+		}
+	};
+
+	// topic_bus dispatches on hierarchical topic names like "orders.eu.filled"
+	// subscription patterns may use
+	//   "*" matches exactly one segment
+	//   "#" matches zero or more segments
+	// every pattern owns a signal_impl, the patterns are indexed by a trie
+	// an interned topic is resolved to its list of matching signals once, the result is cached
+	// and reused until a new pattern is subscribed
+	// publishing by a name that isn't interned resolves it on each call and keeps nothing,
+	// only intern() creates a topic id, so the table doesn't grow with the names published
+	template<class Signature>
+	class topic_bus;
+
+	template<class Return, class... Args>
+	class topic_bus<Return(Args...)>
+	{
+	public:
+		using signal_type = signal_impl<Return, Args...>;
+		using topic_id = size_t;
+
+		topic_bus() { fNodes.emplace_back(); }
+		topic_bus(topic_bus const &) = delete;
+		topic_bus &operator=(topic_bus const &) = delete;
+
+		// map topic name to a dense id, publish(topic_id, ...) costs no hash lookup at all
+		topic_id intern(std::string const &topic)
+		{
+			auto it = fTopicIds.find(topic);
+			if (it != fTopicIds.end()) return it->second;
+			topic_id id = fTopics.size();
+			fTopics.emplace_back();
+			fTopics.back().fName = topic;
+			fTopicIds.emplace(topic, id);
+			return id;
+		}
+
+		template<class Func>
+		connection subscribe(std::string const &pattern, Func&& func)
+		{
+			return get_pattern_signal(pattern).connect(std::forward<Func>(func));
+		}
+
+		template<class Obj, class... Args1>
+		connection subscribe_emplace(std::string const &pattern, Args1&&... args)
+		{
+			return get_pattern_signal(pattern).template connect_emplace<Obj>(std::forward<Args1>(args)...);
+		}
+
+		void publish(std::string const &topic, Args... args)
+		{
+			auto it = fTopicIds.find(topic);
+			if (it != fTopicIds.end()) return publish(it->second, details::copy_forward<Args>(args)...);
+
+			TISS_ALLOC_PHASE(emit);
+			// a one off resolution, it lives on our stack and nothing can move it
+			std::vector<signal_type*> signals;
+			size_t generation = fGeneration;
+			resolve(topic, signals);
+			for (size_t i = 0; i < signals.size(); ++i) {
+				if (generation != fGeneration) {
+					generation = fGeneration;
+					resolve(topic, signals);
+				}
+				// copy before you forward
+				(*signals[i])(details::copy_forward<Args>(args)...);
+			}
+		}
+
+		void publish(topic_id id, Args... args)
+		{
+			TISS_ALLOC_PHASE(emit);
+			if (fTopics[id].fGeneration != fGeneration) resolve(fTopics[id]);
+			// a slot may subscribe or intern, fTopics and the list may move under us
+			// patterns are only added and the list is sorted by pattern, so a new resolution
+			// only appends, and the new patterns are published to as well, like slots connected during emission
+			for (size_t i = 0; i < fTopics[id].fSignals.size(); ++i) {
+				if (fTopics[id].fGeneration != fGeneration) resolve(fTopics[id]);
+				// copy before you forward
+				(*fTopics[id].fSignals[i])(details::copy_forward<Args>(args)...);
+			}
+		}
+
+		size_t num_patterns() const { return fSignals.size(); }
+		size_t num_topics() const { return fTopics.size(); }
+
+		void disconnect_all()
+		{
+			for (auto &sig : fSignals) sig->disconnect_all();
+		}
+
+	private:
+		struct trie_node {
+			std::unordered_map<std::string, size_t> fChildren;
+			size_t fStar = 0; // 0 means no child, the root is never a child
+			size_t fHash = 0;
+			std::vector<size_t> fPatterns;
+		};
+
+		struct topic_entry {
+			std::string fName;
+			size_t fGeneration = 0;
+			std::vector<signal_type*> fSignals;
+		};
+
+		std::vector<trie_node> fNodes;
+		std::vector<std::unique_ptr<signal_type> > fSignals;
+		std::unordered_map<std::string, size_t> fPatternIds;
+		std::unordered_map<std::string, topic_id> fTopicIds;
+		std::vector<topic_entry> fTopics;
+		// bumped when a pattern is added, the cached resolutions are stale then
+		// generation 0 is never current, so fresh topics are always resolved
+		size_t fGeneration = 1;
+
+		static std::vector<std::string> split(std::string const &name)
+		{
+			std::vector<std::string> segs;
+			size_t b = 0;
+			for (;;) {
+				size_t e = name.find('.', b);
+				if (e == std::string::npos) {
+					segs.push_back(name.substr(b));
+					return segs;
+				}
+				segs.push_back(name.substr(b, e - b));
+				b = e + 1;
+			}
+		}
+
+		size_t child(size_t node, std::string const &seg)
+		{
+			size_t c;
+			if (seg == "*") c = fNodes[node].fStar;
+			else if (seg == "#") c = fNodes[node].fHash;
+			else {
+				auto it = fNodes[node].fChildren.find(seg);
+				c = it == fNodes[node].fChildren.end() ? 0 : it->second;
+			}
+			if (c) return c;
+
+			c = fNodes.size();
+			fNodes.emplace_back(); // invalidates references to fNodes
+			if (seg == "*") fNodes[node].fStar = c;
+			else if (seg == "#") fNodes[node].fHash = c;
+			else fNodes[node].fChildren.emplace(seg, c);
+			return c;
+		}
+
+		signal_type &get_pattern_signal(std::string const &pattern)
+		{
+			auto it = fPatternIds.find(pattern);
+			if (it != fPatternIds.end()) return *fSignals[it->second];
+
+			size_t node = 0;
+			for (auto &seg : split(pattern)) node = child(node, seg);
+
+			size_t idx = fSignals.size();
+			fSignals.emplace_back(new signal_type());
+			fNodes[node].fPatterns.push_back(idx);
+			fPatternIds.emplace(pattern, idx);
+			++fGeneration;
+			return *fSignals[idx];
+		}
+
+		void match(size_t node, std::vector<std::string> const &segs, size_t i, std::vector<size_t> &out) const
+		{
+			auto &n = fNodes[node];
+			if (n.fHash) {
+				for (size_t j = i; j <= segs.size(); ++j) match(n.fHash, segs, j, out);
+			}
+			if (i == segs.size()) {
+				out.insert(out.end(), n.fPatterns.begin(), n.fPatterns.end());
+				return;
+			}
+			auto it = n.fChildren.find(segs[i]);
+			if (it != n.fChildren.end()) match(it->second, segs, i + 1, out);
+			if (n.fStar) match(n.fStar, segs, i + 1, out);
+		}
+
+		void resolve(std::string const &name, std::vector<signal_type*> &signals) const
+		{
+			std::vector<size_t> idx;
+			match(0, split(name), 0, idx);
+			// "#" may reach the same pattern in more than one way
+			// keep subscription order
+			std::sort(idx.begin(), idx.end());
+			idx.erase(std::unique(idx.begin(), idx.end()), idx.end());
+			signals.clear();
+			for (auto i : idx) signals.push_back(fSignals[i].get());
+		}
+
+		void resolve(topic_entry &topic)
+		{
+			resolve(topic.fName, topic.fSignals);
+			topic.fGeneration = fGeneration;
+		}
+	};
+
+
+	// join: run once when every signal has emitted for the same key
+	// tiss::join(quote, position, risk, [](auto const &m) { return m.seq; }).connect(f)
+	// f gets the arguments of all the signals, in order
+	// the partial joins wait in a ring of Window entries, indexed by the hash of the key
+	// a key landing on an entry held by another key evicts it, the newest key wins
+	// a signal emitting twice for a key before the join completes overwrites its arguments
+	// the ring is allocated once by connect, events only move arguments in and out
+	struct join_stats {
+		size_t completed = 0;
+		size_t evicted = 0;
+	};
+
+	// the connections of a join, one per signal
+	template<size_t N>
+	class join_connection {
+	public:
+		join_connection() { }
+		explicit join_connection(std::array<connection, N> connections) : fConnections(std::move(connections)) { }
+
+		// true while any of the signals is connected
+		bool connected() {
+			for (auto &con : fConnections) {
+				if (con.connected()) return true;
+			}
+			return false;
+		}
+
+		void disconnect() {
+			for (auto &con : fConnections) con.disconnect();
+		}
+
+		connection &operator[](size_t i) { return fConnections[i]; }
+
+	private:
+		std::array<connection, N> fConnections;
+	};
+
+	namespace details {
+		template<class Return, class... Args>
+		std::tuple<std::decay_t<Args>...> join_message(signal_impl<Return, Args...> *);
+
+		template<class Signal>
+		using join_message_type = decltype(join_message(std::declval<Signal*>()));
+
+		template<class KeyFn, class Message>
+		struct join_key;
+
+		template<class KeyFn, class... Args>
+		struct join_key<KeyFn, std::tuple<Args...>> {
+			using type = std::decay_t<decltype(std::declval<KeyFn&>()(std::declval<Args const&>()...))>;
+		};
+
+		// the arguments of one signal, alive if the bit of the signal is set in the entry's mask
+		template<class Message>
+		struct join_cell {
+			union {
+				Message fMessage;
+			};
+			join_cell() { }
+			~join_cell() { }
+		};
+
+		template<size_t Window, class KeyFn, class Func, class... Messages>
+		struct join_state {
+			static const uint32_t all = (uint32_t(1) << sizeof...(Messages)) - 1;
+			static_assert(sizeof...(Messages) <= 31, "too many signals to join");
+			using key_type = typename join_key<KeyFn, std::tuple_element_t<0, std::tuple<Messages...>>>::type;
+
+			struct entry {
+				key_type fKey{};
+				uint32_t fMask = 0;
+				std::tuple<join_cell<Messages>...> fCells;
+			};
+
+			KeyFn fKeyFn;
+			Func fFunc;
+			join_stats *fStats;
+			size_t fRefs = 0; // one per slot
+			std::array<entry, Window> fRing;
+
+			template<class KeyFn1, class Func1>
+			join_state(KeyFn1&& key_fn, Func1&& func, join_stats *stats)
+				: fKeyFn(std::forward<KeyFn1>(key_fn)), fFunc(std::forward<Func1>(func)), fStats(stats) { }
+
+			~join_state() {
+				for (auto &e : fRing) Clear(e, std::index_sequence_for<Messages...>());
+			}
+
+			void Release() {
+				if (--fRefs == 0) delete this;
+			}
+
+			template<size_t I, class... Args1>
+			void Put(Args1 const &... args) {
+				using message_type = std::tuple_element_t<I, std::tuple<Messages...>>;
+				const uint32_t bit = uint32_t(1) << I;
+				key_type key = fKeyFn(args...);
+				entry &e = fRing[std::hash<key_type>()(key) % Window];
+				if (e.fMask && !(e.fKey == key)) {
+					Clear(e, std::index_sequence_for<Messages...>());
+					if (fStats) ++fStats->evicted;
+				}
+				auto &cell = std::get<I>(e.fCells);
+				if (e.fMask & bit) {
+					cell.fMessage = message_type(args...);
+				} else {
+					new((void*)&cell.fMessage) message_type(args...);
+					if (!e.fMask) e.fKey = std::move(key);
+					e.fMask |= bit;
+				}
+				if (e.fMask == all) Complete(e, std::index_sequence_for<Messages...>());
+			}
+
+			template<size_t... I>
+			void Clear(entry &e, std::index_sequence<I...>) {
+				int dummy[] = { 0, (e.fMask & (uint32_t(1) << I) ? std::get<I>(e.fCells).fMessage.~Messages(), 0 : 0)... };
+				(void)dummy;
+				e.fMask = 0;
+			}
+
+			template<size_t... I>
+			void Complete(entry &e, std::index_sequence<I...>) {
+				// the entry is free before f runs, f may emit again
+				auto args = std::tuple_cat(std::move(std::get<I>(e.fCells).fMessage)...);
+				Clear(e, std::index_sequence_for<Messages...>());
+				if (fStats) ++fStats->completed;
+				++fRefs; // f may disconnect the join
+				Call(args, std::make_index_sequence<std::tuple_size<decltype(args)>::value>());
+				Release();
+			}
+
+			template<class Tuple, size_t... I>
+			void Call(Tuple &args, std::index_sequence<I...>) {
+				fFunc(std::get<I>(args)...);
+			}
+		};
+
+		// the functor in the list of the I-th signal of a join
+		template<class Return, class State, size_t I>
+		struct join_slot {
+			static const bool owner_thread_only = true; // releases the join state
+			State *fState;
+
+			join_slot(State *state) : fState(state) { ++fState->fRefs; }
+			join_slot(join_slot const &) = delete;
+
+			~join_slot() {
+				fState->Release();
+			}
+
+			template<class... Args1>
+			Return operator()(Args1 const &... args) const
+			{
+				fState->template Put<I>(args...);
+				return Return();
+			}
+		};
+
+		template<size_t Window, class KeyFn, class... Signals>
+		struct join_builder {
+			std::tuple<Signals&...> fSignals;
+			KeyFn fKeyFn;
+
+			template<class Func>
+			join_connection<sizeof...(Signals)> connect(Func&& func, join_stats *stats = nullptr) {
+				using state_type = join_state<Window, KeyFn, std::decay_t<Func>, join_message_type<Signals>...>;
+				auto *state = new state_type(std::move(fKeyFn), std::forward<Func>(func), stats);
+				return Connect(state, std::index_sequence_for<Signals...>());
+			}
+
+			template<class State, size_t... I>
+			join_connection<sizeof...(Signals)> Connect(State *state, std::index_sequence<I...>) {
+				++state->fRefs; // not freed by the first slot that fails to connect
+				std::array<connection, sizeof...(Signals)> connections = { { ConnectOne<I>(std::get<I>(fSignals), state)... } };
+				state->Release();
+				return join_connection<sizeof...(Signals)>(std::move(connections));
+			}
+
+			template<size_t I, class State, class Return, class... Args>
+			static connection ConnectOne(signal_impl<Return, Args...> &signal, State *state) {
+				return signal.template connect_emplace<join_slot<Return, State, I>>(state);
+			}
+		};
+
+		template<size_t Window, class Tuple, size_t... I>
+		auto make_join(Tuple &&args, std::index_sequence<I...>) {
+			using key_fn_type = std::decay_t<std::tuple_element_t<sizeof...(I), std::decay_t<Tuple>>>;
+			return join_builder<Window, key_fn_type, std::remove_reference_t<std::tuple_element_t<I, std::decay_t<Tuple>>>...>{
+				std::forward_as_tuple(std::get<I>(args)...), std::get<sizeof...(I)>(args) };
+		}
+	}
+
+	// join(signals..., key_fn), key_fn maps the arguments of every signal to the key
+	template<size_t Window = 64, class... SignalsAndKeyFn>
+	auto join(SignalsAndKeyFn&&... args)
+	{
+		static_assert(sizeof...(SignalsAndKeyFn) >= 3, "join needs two signals and a key function");
+		return details::make_join<Window>(std::forward_as_tuple(std::forward<SignalsAndKeyFn>(args)...),
+			std::make_index_sequence<sizeof...(SignalsAndKeyFn) - 1>());
+	}
 
-		bool operator!=(_Result_iterator_impl const &r) const
+	// reactive values
+	// property<T> is set by the user, computed<T> is a function of other properties and computeds
+	// setting a property marks everything downstream dirty, nothing is recomputed yet
+	// when the outermost transaction ends (or right away without one), the dirty nodes that have listeners
+	// are brought up to date, each pulls its dirty inputs first, so every node is recomputed at most once
+	// and only if one of its inputs really changed
+	// nodes nobody listens to stay dirty until get()
+	// then the changed signals fire, in topological order, with every value already up to date
+	// single thread, the graph of a thread is not seen by other threads
+	namespace details {
+		struct reactive_node {
+			uint32_t fHeight = 0; // longest path from a property
+			bool fDirty = false;
+			bool fQueued = false;
+			bool fToNotify = false;
+			uint64_t fMarkedAt = 0;   // batch that last marked us
+			uint64_t fChangedAt = 0;  // clock of the last change of the value
+			uint64_t fComputedAt = 0; // clock when the value was last brought up to date
+			std::vector<reactive_node*> fDependents;
+
+			reactive_node() { }
+			reactive_node(reactive_node const &) = delete;
+			reactive_node &operator=(reactive_node const &) = delete;
+			virtual ~reactive_node() { }
+
+			// bring the value up to date
+			virtual void Update() { }
+			virtual bool Observed() const = 0;
+			virtual void Notify() = 0;
+
+			void RemoveDependent(reactive_node *n) {
+				fDependents.erase(std::remove(fDependents.begin(), fDependents.end(), n), fDependents.end());
+			}
+		};
+
+		struct reactive_context {
+			int fDepth = 0;
+			uint64_t fBatch = 1;
+			uint64_t fClock = 0; // ticks on every change
+			bool fOpen = false; // fBatch has been used by a change
+			std::vector<reactive_node*> fPending; // dirty and observed
+			std::vector<reactive_node*> fChanged;
+			std::vector<reactive_node*> fNotifying; // fChanged of the batch being notified
+
+			void Begin() { ++fDepth; }
+
+			void End() {
+				if (--fDepth == 0) Commit();
+			}
+
+			// a property changed, called with the value already stored
+			void Changed(reactive_node *n) {
+				n->fChangedAt = ++fClock;
+				Notify(n);
+				Mark(n);
+			}
+
+			// notify once per batch, however often the value changed in it
+			void Notify(reactive_node *n) {
+				fOpen = true;
+				if (n->fToNotify) return;
+				n->fToNotify = true;
+				fChanged.push_back(n);
+			}
+
+			void Mark(reactive_node *n) {
+				for (auto *d : n->fDependents) {
+					// a node brought up to date by get() in the middle of a batch is marked again
+					if (d->fMarkedAt == fBatch && d->fDirty) continue;
+					d->fMarkedAt = fBatch;
+					d->fDirty = true;
+					if (!d->fQueued && d->Observed()) {
+						d->fQueued = true;
+						fPending.push_back(d);
+					}
+					Mark(d);
+				}
+			}
+
+			// a node destroyed in a transaction or by a listener, its entries are nulled
+			void Forget(reactive_node *n) {
+				if (n->fQueued) std::replace(fPending.begin(), fPending.end(), n, (reactive_node*)nullptr);
+				if (n->fToNotify) std::replace(fChanged.begin(), fChanged.end(), n, (reactive_node*)nullptr);
+				std::replace(fNotifying.begin(), fNotifying.end(), n, (reactive_node*)nullptr);
+			}
+
+			TISS_NOINLINE void Commit() {
+				// listeners may set properties, that is a new batch
+				while (fOpen) {
+					++fDepth;
+					auto by_height = [](reactive_node *a, reactive_node *b) { return a->fHeight < b->fHeight; };
+					fPending.erase(std::remove(fPending.begin(), fPending.end(), nullptr), fPending.end());
+					std::stable_sort(fPending.begin(), fPending.end(), by_height);
+					for (size_t i = 0; i < fPending.size(); ++i) {
+						if (!fPending[i]) continue;
+						fPending[i]->fQueued = false;
+						fPending[i]->Update();
+					}
+					fPending.clear();
+
+					fNotifying.swap(fChanged);
+					fNotifying.erase(std::remove(fNotifying.begin(), fNotifying.end(), nullptr), fNotifying.end());
+					std::stable_sort(fNotifying.begin(), fNotifying.end(), by_height);
+					fOpen = false;
+					++fBatch;
+					for (auto *n : fNotifying) n->fToNotify = false;
+					for (size_t i = 0; i < fNotifying.size(); ++i) {
+						if (fNotifying[i]) fNotifying[i]->Notify();
+					}
+					fNotifying.clear();
+					--fDepth;
+				}
+			}
+		};
+
+		inline reactive_context &reactive()
 		{
-			return _fNode != r._fNode;
+			static thread_local reactive_context context;
+			return context;
 		}
 
-		_Result_iterator_impl &operator++()
-		{
-			_fNode = _fNode->fNext;
-			for (; _fNode != _fHead && !static_cast<_Body *>(_fNode)->fConnected; _fNode = _fNode->fNext) { }
+		template<class T>
+		struct reactive_value : reactive_node {
+			T fValue;
+			signal<void(T const&)> changed;
+
+			template<class... Args1>
+			reactive_value(Args1&&... args) : fValue(std::forward<Args1>(args)...) { }
+			~reactive_value() { reactive().Forget(this); }
+
+			bool Observed() const override { return changed.num_connections() != 0; }
+			void Notify() override { changed(fValue); }
+		};
+
+		template<class T>
+		struct compute_base {
+			virtual ~compute_base() { }
+			virtual T Compute() = 0;
+		};
+
+		// the function of a computed, by its own type, with its deps
+		template<class T, class Func, class... Deps>
+		struct compute_body final : compute_base<T> {
+			Func fFunc;
+			std::tuple<Deps&...> fDeps;
+
+			template<class Func1>
+			compute_body(Func1 &&func, Deps&... deps) : fFunc(std::forward<Func1>(func)), fDeps(deps...) { }
+
+			T Compute() override { return Call(std::index_sequence_for<Deps...>()); }
+
+			template<size_t... I>
+			T Call(std::index_sequence<I...>) { return fFunc(std::get<I>(fDeps).get()...); }
+		};
+	}
+
+	// group changes, dependents are brought up to date and notified once, when the outermost transaction ends
+	class transaction {
+	public:
+		transaction() { details::reactive().Begin(); }
+		~transaction() { details::reactive().End(); }
+		transaction(transaction const &) = delete;
+		transaction &operator=(transaction const &) = delete;
+	};
+
+	// the computeds that depend on a property must go before it
+	template<class T>
+	class property : private details::reactive_value<T> {
+		using base_type = details::reactive_value<T>;
+	public:
+		property() : base_type() { }
+		property(T value) : base_type(std::move(value)) { }
+
+		using base_type::changed;
+
+		T const &get() const { return this->fValue; }
+		operator T const &() const { return this->fValue; }
+
+		// nothing happens if value equals the current one
+		void set(T value) {
+			if (value == this->fValue) return;
+			this->fValue = std::move(value);
+			auto &ctx = details::reactive();
+			ctx.Begin();
+			ctx.Changed(this);
+			ctx.End();
+		}
+
+		property &operator=(T value) {
+			set(std::move(value));
 			return *this;
 		}
 
-		_Result_iterator_impl operator++(int)
-		{
-			_Result_iterator_impl t = *this
-			++(*this);
-			return t;
+		details::reactive_node *node() { return this; }
+	};
+
+	// computed<T> c(dep1, dep2, ..., f), f(dep1.get(), dep2.get(), ...) gives the value
+	// a dep is a property or a computed, it must outlive c
+	template<class T>
+	class computed : private details::reactive_value<T> {
+		using base_type = details::reactive_value<T>;
+	public:
+		template<class... DepsAndFunc>
+		computed(DepsAndFunc&&... deps_and_func)
+			: computed(std::forward_as_tuple(std::forward<DepsAndFunc>(deps_and_func)...),
+				std::make_index_sequence<sizeof...(DepsAndFunc) - 1>()) { }
+
+		~computed() {
+			for (auto *dep : fDeps) dep->RemoveDependent(this);
 		}
 
-		template<std::size_t... I>
-		Result _Invoke(_Body &body, _Tuple *args, std::index_sequence<I>...) const
-		{
-			// make a copy and invoke
-			return body.Invoke(details::copy_forward<Args>(std::get<I>(*args)...)...);
+		using base_type::changed;
+
+		T const &get() {
+			Update();
+			return this->fValue;
 		}
+		operator T const &() { return get(); }
 
-		Result operator*() const
+		details::reactive_node *node() { return this; }
+
+		void Update() override {
+			if (!this->fDirty) return;
+			this->fDirty = false;
+			bool inputs_changed = false;
+			for (auto *dep : fDeps) {
+				dep->Update();
+				if (dep->fChangedAt > this->fComputedAt) inputs_changed = true;
+			}
+			auto &ctx = details::reactive();
+			this->fComputedAt = ctx.fClock;
+			if (!inputs_changed) return;
+			T value = fCompute->Compute();
+			if (value == this->fValue) return;
+			this->fValue = std::move(value);
+			this->fChangedAt = ++ctx.fClock;
+			ctx.Notify(this);
+		}
+
+	private:
+		std::vector<details::reactive_node*> fDeps;
+		// computed<T> doesn't name the type of the function, it lives in a body
+		std::unique_ptr<details::compute_base<T> > fCompute;
+
+		template<class Tuple, size_t... I>
+		computed(Tuple &&args, std::index_sequence<I...>)
+			: base_type(std::get<sizeof...(I)>(args)(std::get<I>(args).get()...))
 		{
-			auto &body = static_cast<_Body &>(*_fNode);
-			return _Invoke(body, _fArgs, std::make_index_sequence<sizeof...(Args)>());
+			// the function is moved in if it was passed as an rvalue
+			using func_type = typename std::tuple_element<sizeof...(I), typename std::decay<Tuple>::type>::type;
+			fCompute.reset(MakeCompute(std::forward<func_type>(std::get<sizeof...(I)>(args)), std::get<I>(args)...));
+			details::reactive_node *deps[] = { nullptr, std::get<I>(args).node()... };
+			for (size_t i = 1; i < sizeof(deps) / sizeof(deps[0]); ++i) {
+				fDeps.push_back(deps[i]);
+				deps[i]->fDependents.push_back(this);
+				if (deps[i]->fHeight + 1 > this->fHeight) this->fHeight = deps[i]->fHeight + 1;
+			}
+			this->fComputedAt = details::reactive().fClock;
+		}
+
+		template<class Func, class... Deps>
+		static details::compute_base<T> *MakeCompute(Func &&func, Deps&... deps) {
+			return new details::compute_body<T, typename std::decay<Func>::type, Deps...>(std::forward<Func>(func), deps...);
 		}
 	};
 
-	template<class Signature>
-	struct _Get_result_iterator_impl;
+	// DOM style propagation over a tree of nodes, each node has a capture and a bubble signal
+	// dispatch(target, event) emits capture from the root down to the parent of the target,
+	// then capture and bubble of the target, then bubble from the parent up to the root
+	// a handler returns false to stop the propagation, the rest of the path is skipped
+	// the path of a node is cached, reparent and remove invalidate all the caches at once
+	// and each one is rebuilt by the next dispatch to its node
+	// handlers may add nodes and reparent, the dispatch in progress keeps its path
+	// a node must not be removed while one of its signals is emitting
+	template<class Event>
+	class propagation_tree {
+	public:
+		using node_id = uint32_t;
+		using signal_type = signal<bool(Event&)>;
+		static const node_id no_node = ~node_id(0);
 
-	template<class Return, class... Args>
-	struct _Get_result_iterator_impl<Return(Args...)> {
-		using type = _Result_iterator_impl<Return, Args...>;
-	};
+		node_id add(node_id parent = no_node) {
+			node_id id;
+			if (fFree != no_node) {
+				id = fFree;
+				fFree = fNodes[id].fNextSibling;
+			} else {
+				id = (node_id)fNodes.size();
+				fNodes.emplace_back();
+			}
+			node &n = fNodes[id];
+			n.fPathVersion = 0;
+			n.fPath.clear();
+			Link(id, parent);
+			++fSize;
+			return id;
+		}
 
-	template<class Signature>
-	struct result_iterator : _Get_result_iterator_impl<Signature>::type
-	{
-		using _MyBase = typename _Get_result_iterator_impl<Signature>::type;
-		using _Signal = typename _MyBase::_Signal;
-		using _Node = details::linked;
-		using _Body = typename _MyBase::_Body;
-		using _Tuple = typename _MyBase::_Tuple;
+		// remove the node and its subtree, their signals are disconnected
+		void remove(node_id id) {
+			++fVersion;
+			Unlink(id);
+			Free(id);
+		}
 
-		result_iterator(
-			_Node *node,
-			_Node const *head,
-			_Tuple *args) : _MyBase(node, head, args)
-		{
+		// false if parent is in the subtree of the node
+		bool reparent(node_id id, node_id parent) {
+			for (node_id p = parent; p != no_node; p = fNodes[p].fParent) {
+				if (p == id) return false;
+			}
+			++fVersion;
+			Unlink(id);
+			Link(id, parent);
+			return true;
+		}
+
+		node_id parent(node_id id) const { return fNodes[id].fParent; }
+		size_t size() const { return fSize; }
+
+		signal_type &capture(node_id id) { return fNodes[id].fCapture; }
+		signal_type &bubble(node_id id) { return fNodes[id].fBubble; }
+
+		// return false if a handler stopped the propagation
+		bool dispatch(node_id target, Event &event) {
+			std::vector<node*> scratch;
+			std::vector<node*> const &path = Path(target, scratch);
+			++fDispatching;
+			bool done = Walk(path, fNodes[target], event);
+			--fDispatching;
+			return done;
+		}
+
+	private:
+		struct node {
+			node_id fParent = no_node;
+			node_id fFirstChild = no_node;
+			node_id fNextSibling = no_node; // next free node when removed
+			node_id fPrevSibling = no_node;
+			uint64_t fPathVersion = 0;
+			std::vector<node*> fPath; // root first, the parent last
+			signal_type fCapture;
+			signal_type fBubble;
+		};
+
+		// a deque, so a node doesn't move when a handler adds one, and the paths can point at them
+		std::deque<node> fNodes;
+		node_id fFree = no_node;
+		size_t fSize = 0;
+		uint64_t fVersion = 1;
+		uint32_t fDispatching = 0;
+
+		static bool Walk(std::vector<node*> const &path, node &target, Event &event) {
+			size_t depth = path.size();
+			for (size_t i = 0; i < depth; ++i) {
+				if (!path[i]->fCapture.emit_util_false(event)) return false;
+			}
+			if (!target.fCapture.emit_util_false(event)) return false;
+			if (!target.fBubble.emit_util_false(event)) return false;
+			for (size_t i = depth; i-- > 0; ) {
+				if (!path[i]->fBubble.emit_util_false(event)) return false;
+			}
+			return true;
+		}
+
+		std::vector<node*> const &Path(node_id id, std::vector<node*> &scratch) {
+			node &n = fNodes[id];
+			if (n.fPathVersion == fVersion) return n.fPath;
+			// an outer dispatch may be walking the cached path
+			std::vector<node*> &path = fDispatching ? scratch : n.fPath;
+			path.clear();
+			for (node_id p = n.fParent; p != no_node; p = fNodes[p].fParent) path.push_back(&fNodes[p]);
+			std::reverse(path.begin(), path.end());
+			if (&path == &n.fPath) n.fPathVersion = fVersion;
+			return path;
+		}
+
+		void Link(node_id id, node_id parent) {
+			node &n = fNodes[id];
+			n.fParent = parent;
+			n.fPrevSibling = no_node;
+			n.fNextSibling = no_node;
+			if (parent == no_node) return;
+			node &p = fNodes[parent];
+			n.fNextSibling = p.fFirstChild;
+			if (p.fFirstChild != no_node) fNodes[p.fFirstChild].fPrevSibling = id;
+			p.fFirstChild = id;
+		}
+
+		void Unlink(node_id id) {
+			node &n = fNodes[id];
+			if (n.fPrevSibling != no_node) {
+				fNodes[n.fPrevSibling].fNextSibling = n.fNextSibling;
+			} else if (n.fParent != no_node) {
+				fNodes[n.fParent].fFirstChild = n.fNextSibling;
+			}
+			if (n.fNextSibling != no_node) fNodes[n.fNextSibling].fPrevSibling = n.fPrevSibling;
+			n.fParent = no_node;
+			n.fPrevSibling = no_node;
+			n.fNextSibling = no_node;
 		}
+
+		void Free(node_id id) {
+			for (node_id c = fNodes[id].fFirstChild; c != no_node; ) {
+				node_id next = fNodes[c].fNextSibling;
+				Free(c);
+				c = next;
+			}
+			node &n = fNodes[id];
+			n.fCapture.disconnect_all();
+			n.fBubble.disconnect_all();
+			n.fFirstChild = no_node;
+			n.fParent = no_node;
+			n.fNextSibling = fFree;
+			fFree = id;
+			--fSize;
+		}
+	};
+}
+
+#if TISS_REGISTRY
+namespace tiss {
+
+	struct signal_info {
+		std::string name;
+		std::string signature;
+		bool alive;
+		size_t live_slots;
+		size_t live_bytes;
+		size_t pinned_slots; // disconnected, memory kept by connection handles
+		size_t pinned_bytes;
+		size_t emissions;
 	};
 
-	template<class Signature>
-	struct result_range
+	// the counters are read while other threads may update them, so the numbers are approximate
+	inline std::vector<signal_info> registry_snapshot()
 	{
-		using _Tuple = typename _Get_Tuple<Signature>::type;
-		using _Iter = result_iterator<Signature>;
-		using _Node = details::linked;
+		auto &reg = details::registry();
+		std::lock_guard<std::mutex> lock(reg.fMutex);
+		std::vector<signal_info> infos;
+		for (auto *r : reg.fRecords) {
+			if (!r) continue;
+			signal_info info;
+			info.name = r->fName;
+			info.signature = r->fSignature;
+			info.alive = r->fAlive;
+			info.live_slots = r->fLive.load(std::memory_order_relaxed);
+			info.live_bytes = r->fLiveBytes.load(std::memory_order_relaxed);
+			info.pinned_slots = r->fPinned.load(std::memory_order_relaxed);
+			info.pinned_bytes = r->fPinnedBytes.load(std::memory_order_relaxed);
+			info.emissions = r->fEmissions.load(std::memory_order_relaxed);
+			infos.push_back(std::move(info));
+		}
+		return infos;
+	}
 
-		_Tuple _fTuple;
-		_Iter _fBegin;
-		_Iter _fEnd;
+	inline std::string registry_dump_json()
+	{
+		auto quote = [](std::string const &str) {
+			std::string out = "\"";
+			for (char c : str) {
+				if (c == '"' || c == '\\') out += '\\';
+				if ((unsigned char)c < 0x20) continue;
+				out += c;
+			}
+			return out + "\"";
+		};
 
-		template<class... Args1>
-		result_range(_Node *b, _Node const *e, Args1&&... args) :
-			_fTuple(std::forward<Args1>(args)...),
-			_fBegin(b, e, &_fTuple), 
-			_fEnd((_Node*)e, e, &_fTuple)
-		{
+		std::string json = "[";
+		char buf[256];
+		bool first = true;
+		for (auto &info : registry_snapshot()) {
+			json += first ? "\n" : ",\n";
+			first = false;
+			json += "{\"name\":" + quote(info.name) + ",\"signature\":" + quote(info.signature);
+			snprintf(buf, sizeof(buf),
+				",\"alive\":%s,\"live_slots\":%zu,\"live_bytes\":%zu"
+				",\"pinned_slots\":%zu,\"pinned_bytes\":%zu,\"emissions\":%zu}",
+				info.alive ? "true" : "false", info.live_slots, info.live_bytes,
+				info.pinned_slots, info.pinned_bytes, info.emissions);
+			json += buf;
 		}
+		return json + "\n]\n";
+	}
+}
+#endif
 
-		_Iter begin() const
-		{
-			return _fBegin;
+#if TISS_JOURNAL || TISS_IPC
+namespace tiss {
+
+	// how an argument is written to a journal or an ipc_signal
+	// trivially copyable types are copied as they are, std::string is a length and the bytes
+	// specialize it for other types:
+	//   static size_t size(T const &v);         bytes write() uses
+	//   static void write(char *out, T const &v);
+	//   static T read(char const *&in);         moves in past the value
+	template<class T, class Enable = void>
+	struct journal_traits;
+
+	template<class T>
+	struct journal_traits<T, std::enable_if_t<std::is_trivially_copyable<T>::value> > {
+		static size_t size(T const &) { return sizeof(T); }
+		static void write(char *out, T const &v) { memcpy(out, &v, sizeof(T)); }
+		static T read(char const *&in) {
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type buf;
+			memcpy(&buf, in, sizeof(T));
+			in += sizeof(T);
+			return *reinterpret_cast<T*>(&buf);
 		}
+	};
 
-		_Iter end() const
-		{
-			return _fEnd;
+	template<>
+	struct journal_traits<std::string> {
+		static size_t size(std::string const &v) { return sizeof(uint32_t) + v.size(); }
+		static void write(char *out, std::string const &v) {
+			uint32_t n = (uint32_t)v.size();
+			memcpy(out, &n, sizeof(n));
+			memcpy(out + sizeof(n), v.data(), n);
+		}
+		static std::string read(char const *&in) {
+			uint32_t n;
+			memcpy(&n, in, sizeof(n));
+			std::string v(in + sizeof(n), n);
+			in += sizeof(n) + n;
+			return v;
 		}
 	};
+}
+#endif
 
-	template<class Return, class... Args>
-	struct signal_impl {
-	public:
-		typedef Return Signature (Args...);
-		using connection_type = connection;
-		using connection_body_type = connection_body<Return, Args...>;
-		using connection_bodies_type = details::linked;
+#if TISS_JOURNAL
+namespace tiss {
 
-		connection_bodies_type fConnectionBodies;
+	namespace details {
+		// the file is a header followed by the ring
+		// positions only grow, the offset in the ring is position % capacity
+		// a record never crosses the end of the ring, a record of size 0 means "go on at the start"
+		struct journal_header {
+			uint64_t fMagic;
+			uint64_t fCapacity;
+			uint64_t fHead; // position of the next record
+			uint64_t fTail; // position of the oldest record kept
+			uint64_t fRecorded;
+			uint64_t fDropped; // records larger than the ring
+		};
 
-		signal_impl() { };
-		signal_impl(signal_impl const &) = delete;
-		signal_impl &operator=(signal_impl const &) = delete;
+		struct journal_record {
+			uint32_t fSize; // header included, multiple of 8
+			uint32_t fSignal;
+			uint64_t fTime; // steady clock, ns
+		};
 
-		signal_impl(signal_impl &&r) {
-			if (!r.fConnectionBodies.empty()) {
-				fConnectionBodies.fNext = r.fConnectionBodies.fNext;
-				fConnectionBodies.fPrev = r.fConnectionBodies.fPrev;
-				fConnectionBodies.fNext->fPrev = &fConnectionBodies;
-				fConnectionBodies.fPrev->fNext = &fConnectionBodies;
-				r.fConnectionBodies.fNext = &r.fConnectionBodies;
-				r.fConnectionBodies.fPrev = &r.fConnectionBodies;
+		static const uint64_t journal_magic = 0x314c4e524a535354ull;
+
+		inline size_t journal_align(size_t n) { return (n + 7) & ~size_t(7); }
+
+		inline uint64_t journal_now()
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+	}
+
+	// writes the emissions of the recorded signals to a ring file
+	// when the ring is full the oldest records are overwritten
+	// one thread at a time may emit the recorded signals, as for the signals themselves
+	class journal {
+	public:
+		// create (or truncate) path, capacity is the size of the ring in bytes
+		journal(char const *path, size_t capacity) {
+			capacity = details::journal_align(capacity < 64 ? 64 : capacity);
+			int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+			if (fd < 0) return;
+			size_t bytes = sizeof(details::journal_header) + capacity;
+			if (ftruncate(fd, (off_t)bytes) == 0) {
+				void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				if (mem != MAP_FAILED) {
+					fHeader = (details::journal_header*)mem;
+					fRing = (char*)mem + sizeof(details::journal_header);
+					fMapped = bytes;
+					fHeader->fMagic = details::journal_magic;
+					fHeader->fCapacity = capacity;
+				}
 			}
+			close(fd);
 		}
-		signal_impl &operator=(signal_impl &&r) {
-			if (!r.fConnectionBodies.empty()) {
-				fConnectionBodies.fNext = r.fConnectionBodies.fNext;
-				fConnectionBodies.fPrev = r.fConnectionBodies.fPrev;
-				fConnectionBodies.fNext->fPrev = &fConnectionBodies;
-				fConnectionBodies.fPrev->fNext = &fConnectionBodies;
-				r.fConnectionBodies.fNext = &r.fConnectionBodies;
-				r.fConnectionBodies.fPrev = &r.fConnectionBodies;
+
+		journal(journal const &) = delete;
+		journal &operator=(journal const &) = delete;
+
+		~journal() {
+			for (auto &con : fRecorders) con.disconnect();
+			if (fHeader) munmap(fHeader, fMapped);
+		}
+
+		bool is_open() const { return fHeader != nullptr; }
+		size_t recorded() const { return fHeader ? (size_t)fHeader->fRecorded : 0; }
+		size_t dropped() const { return fHeader ? (size_t)fHeader->fDropped : 0; }
+
+		// record every emission of sig under id, until the connection is disconnected
+		// or the journal is destroyed
+		template<class... Args>
+		connection record(signal_impl<void, Args...> &sig, uint32_t id) {
+			if (!fHeader) return connection();
+			fRecorders.push_back(sig.connect([this, id](auto const &... args) {
+				this->Append(id, args...);
+			}));
+			return fRecorders.back();
+		}
+
+	private:
+		details::journal_header *fHeader = nullptr;
+		char *fRing = nullptr;
+		size_t fMapped = 0;
+		std::vector<connection> fRecorders;
+
+		template<class... Values>
+		void Append(uint32_t id, Values const &... values) {
+			size_t sizes[] = { 0, journal_traits<Values>::size(values)... };
+			size_t bytes = sizeof(details::journal_record);
+			for (size_t n : sizes) bytes += n;
+			char *out = Reserve(id, bytes);
+			if (!out) return;
+			size_t i = 0;
+			int dummy[] = { 0, (journal_traits<Values>::write(out, values), out += sizes[++i], 0)... };
+			(void)dummy;
+			// the record is complete, make it visible
+			fHeader->fHead += details::journal_align(bytes);
+			++fHeader->fRecorded;
+		}
+
+		// write the record header and return where the arguments go
+		char *Reserve(uint32_t id, size_t bytes) {
+			auto &h = *fHeader;
+			bytes = details::journal_align(bytes);
+			if (bytes > h.fCapacity || bytes > UINT32_MAX) {
+				++h.fDropped;
+				return nullptr;
+			}
+			uint64_t offset = h.fHead % h.fCapacity;
+			if (offset + bytes > h.fCapacity) {
+				// no room before the end
+				MakeRoom(h.fCapacity - offset);
+				((details::journal_record*)(fRing + offset))->fSize = 0;
+				h.fHead += h.fCapacity - offset;
+				offset = 0;
 			}
+			MakeRoom(bytes);
+			auto *rec = (details::journal_record*)(fRing + offset);
+			rec->fSize = (uint32_t)bytes;
+			rec->fSignal = id;
+			rec->fTime = details::journal_now();
+			return (char*)(rec + 1);
 		}
 
-		~signal_impl() {
-			disconnect_all();
+		// drop the oldest records until bytes more fit
+		void MakeRoom(size_t bytes) {
+			auto &h = *fHeader;
+			while (h.fHead + bytes - h.fTail > h.fCapacity) {
+				uint64_t offset = h.fTail % h.fCapacity;
+				uint32_t size = ((details::journal_record*)(fRing + offset))->fSize;
+				h.fTail += size ? size : h.fCapacity - offset;
+			}
 		}
+	};
 
-		//static_assert(std::is_move_assignable_v<signal>, "");
-		//static_assert(std::is_move_constructible_v<signal>, "");
+	enum class replay_speed {
+		original, // keep the recorded gaps between emissions
+		fastest,
+	};
 
-		template<class Func>
-		std::enable_if_t<
-			std::is_convertible<
-			    decltype(std::declval<Func>()
-			(std::declval<details::copy_forward_type<Args> >()...)),
-			    Return
-			>::value,
-			connection_type> connect(Func&& func)
-		{
-			using Binder = std::decay_t<Func>;
-			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
-			ptr->initialize(std::forward<Func>(func));
-			fConnectionBodies.push_back(ptr);
-			return ptr;
+	// reads a journal file and emits its records into the bound signals
+	class journal_reader {
+	public:
+		explicit journal_reader(char const *path) {
+			int fd = open(path, O_RDONLY);
+			if (fd < 0) return;
+			struct stat st;
+			if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(details::journal_header)) {
+				void *mem = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mem != MAP_FAILED) {
+					auto *h = (details::journal_header const*)mem;
+					if (h->fMagic == details::journal_magic
+						&& sizeof(details::journal_header) + h->fCapacity <= (size_t)st.st_size) {
+						fHeader = h;
+						fRing = (char const*)mem + sizeof(details::journal_header);
+						fMapped = (size_t)st.st_size;
+					} else {
+						munmap(mem, (size_t)st.st_size);
+					}
+				}
+			}
+			close(fd);
 		}
 
-		template<class Obj, class... Args1>
-		std::enable_if_t<
-			std::is_convertible<
-			    decltype(std::declval<Obj>()
-			        (std::declval<details::copy_forward_type<Args> >()...)),
-			    Return
-			>::value,
-			connection> connect_emplace(Args1&&... args)
-		{
-			using Binder = Obj;
-			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
-			ptr->initialize(std::forward<Args1>(args)...);
-			fConnectionBodies.push_back(ptr);
-			return ptr;
-		}
+		journal_reader(journal_reader const &) = delete;
+		journal_reader &operator=(journal_reader const &) = delete;
 
-		// VS won't inline here
-		// it's not good, becuase there is only invocation point
-		template<class Func1, class... Args1>
-		auto connect_bind(Func1&& func, Args1&&... args)
-			-> std::enable_if_t<
-			std::is_convertible<
-			decltype(std::bind(std::forward<Func1>(func), std::forward<Args1>(args)...)
-			    (std::declval<details::copy_forward_type<Args> >()...)),
-			Return
-			>::value,
-			connection>
-		{
-			using Binder = decltype(std::bind(std::forward<Func1>(func), std::forward<Args1>(args)...));
-			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
-			ptr->initialize_bind(std::forward<Func1>(func), std::forward<Args1>(args)...);
-			fConnectionBodies.push_back(ptr);
-			return ptr;
+		~journal_reader() {
+			if (fHeader) munmap((void*)fHeader, fMapped);
 		}
 
-		// we don't support static function binding, like
-		// template <class T, Return(T::*funcptr)(Args...)>
-		// connection connect_funcptr(T *obj)
-		// we don't do optimization for corner case
-		template<class T> 
-		connection connect_funcptr(T *obj, Return(T::*funcptr)(Args...))
-		{
-			auto stub = [obj, funcptr](details::copy_forward_type<Args>... args)
-			{
-				return (obj->*funcptr)(details::copy_forward<Args>(args)...);
-			};
-			using Binder = decltype(stub);
-			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
-			ptr->initialize(stub);
-			fConnectionBodies.push_back(ptr);
-			return ptr;
-		}
+		bool is_open() const { return fHeader != nullptr; }
 
-		template<class T>
-		connection connect_funcptr(T *obj, Return(T::*funcptr)(Args...) const)
-		{
-			auto stub = [obj, funcptr](details::copy_forward_type<Args>... args)
-			{
-				return (obj->*funcptr)(details::copy_forward<Args>(args)...);
+		// records made under id are emitted by sig
+		// the signal must outlive the reader, or be bound again
+		template<class... Args>
+		void bind(uint32_t id, signal_impl<void, Args...> &sig) {
+			fTargets[id] = [&sig](char const *in) {
+				// braced init reads the arguments in order
+				std::tuple<std::decay_t<Args>...> values{ journal_traits<std::decay_t<Args> >::read(in)... };
+				Emit(sig, values, std::index_sequence_for<Args...>());
 			};
-			using Binder = decltype(stub);
-			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
-			ptr->initialize(stub);
-			fConnectionBodies.push_back(ptr);
-			return ptr;
 		}
 
-		template<class T>
-		connection connect_funcptr(T const *obj, Return(T::*funcptr)(Args...) const)
-		{
-			auto stub = [obj, funcptr](details::copy_forward_type<Args>... args)
-			{
-				return (obj->*funcptr)(details::copy_forward<Args>(args)...);
-			};
-			using Binder = decltype(stub);
-			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
-			ptr->initialize(stub);
-			fConnectionBodies.push_back(ptr);
-			return ptr;
+		// emit the records from the oldest kept one, records of unbound ids are skipped
+		// returns the number of emissions
+		size_t replay(replay_speed speed = replay_speed::fastest) {
+			if (!fHeader) return 0;
+			size_t emitted = 0;
+			uint64_t first = 0;
+			auto start = std::chrono::steady_clock::now();
+			uint64_t cap = fHeader->fCapacity;
+			for (uint64_t pos = fHeader->fTail; pos < fHeader->fHead; ) {
+				uint64_t offset = pos % cap;
+				auto *rec = (details::journal_record const*)(fRing + offset);
+				if (rec->fSize == 0) {
+					pos += cap - offset;
+					continue;
+				}
+				pos += rec->fSize;
+				auto it = fTargets.find(rec->fSignal);
+				if (it == fTargets.end()) continue;
+				if (speed == replay_speed::original) {
+					if (emitted == 0) first = rec->fTime;
+					std::this_thread::sleep_until(start + std::chrono::nanoseconds(rec->fTime - first));
+				}
+				it->second((char const*)(rec + 1));
+				++emitted;
+			}
+			return emitted;
 		}
 
-		connection connect_funcptr(Return(*funcptr)(Args...))
-		{
-			// all things expaned! good!
-			using Binder = Return(*)(Args...);
-			connection_body_derived<Binder, Return, Args...> *ptr = new connection_body_derived<Binder, Return, Args...>();
-			ptr->initialize(funcptr);
-			fConnectionBodies.push_back(ptr);
-			return ptr;
+	private:
+		details::journal_header const *fHeader = nullptr;
+		char const *fRing = nullptr;
+		size_t fMapped = 0;
+		std::unordered_map<uint32_t, std::function<void(char const*)> > fTargets;
+
+		template<class... Args, class Tuple, size_t... I>
+		static void Emit(signal_impl<void, Args...> &sig, Tuple &values, std::index_sequence<I...>) {
+			sig(std::forward<Args>(std::get<I>(values))...);
 		}
+	};
+}
+#endif
 
-		void disconnect_all_slots() { disconnect_all(); }
-		
-		void disconnect_all()
+#if TISS_IPC
+namespace tiss {
+
+	namespace details {
+		// the region is a header followed by fixed size slots
+		// every record goes to the slot of its position, a seqlock guards the slot:
+		// fSeq is 2 * position + 1 while the record is written, 2 * position + 2 when it is done
+		// producers never wait, a reader that falls a whole ring behind loses the records in between
+		struct ipc_header {
+			std::atomic<uint64_t> fMagic;
+			uint64_t fSlots;
+			uint64_t fSlotSize;
+			std::atomic<uint64_t> fHead; // position of the next record
+			std::atomic<uint32_t> fWake; // futex word, bumped by every record
+			std::atomic<uint32_t> fWaiters;
+		};
+
+		struct ipc_slot {
+			std::atomic<uint64_t> fSeq;
+			uint32_t fSize;
+			uint32_t fPad;
+		};
+
+		static const uint64_t ipc_magic = 0x3143504953535431ull;
+
+		// true when every B is, std::conjunction is c++17
+		template<bool... B>
+		struct all_of : std::is_same<all_of<true, B...>, all_of<B..., true> > {};
+
+		static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+			"the ring is shared between processes, the atomics must be lock free");
+
+		inline void futex_wait(std::atomic<uint32_t> *word, uint32_t old, std::chrono::nanoseconds timeout)
 		{
-			auto *end = &fConnectionBodies;
-			for (auto p = fConnectionBodies.fNext; p != end; )
-			{
-				// down cast
-				connection_body_type &body = static_cast<connection_body_type &>(*p);
-				p = p->fNext;
-				body.Disconnect();
-			}
+			struct timespec ts;
+			ts.tv_sec = (time_t)(timeout.count() / 1000000000);
+			ts.tv_nsec = (long)(timeout.count() % 1000000000);
+			syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, old, &ts, nullptr, 0);
 		}
 
-		size_t num_connections()
+		inline void futex_wake_all(std::atomic<uint32_t> *word)
 		{
-			size_t num = 0;
-			auto *end = &fConnectionBodies;
-			for (auto p = fConnectionBodies.fNext; p != end; )
-			{
-				// down cast
-				connection_body_type &body = static_cast<connection_body_type &>(*p);
-				p = p->fNext;
-				if (body.fConnected) num += 1;
-			}
-			return num;
+			syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
 		}
+	}
 
-		// VS won't inline here
-		// it's good, because there are many invocation points!
-		
-		void operator()(Args... args) const
-		{
-			auto *end = &fConnectionBodies;
-			for (auto p = fConnectionBodies.fNext; p != end; )
-			{
-				// down cast
-				connection_body_type &body = static_cast<connection_body_type &>(*p);
+	template<class Signature>
+	class ipc_signal;
 
-				if (body.fConnected) {
-					details::auto_lock<Return, Args...> auto_lock(body);  //prevent unlink from list
-																		  // impossible inline
-					// copy before you forward
-					body.Invoke(details::copy_forward<Args>(args)...);
-					p = p->fNext;
+	// every process that opens the same name shares the ring
+	// emit() writes a record into the ring, poll()/wait() dispatch the records written
+	// since the last call (by any process, this one included) to the local slots
+	// arguments go through journal_traits, all processes must agree on the signature
+	// trivially copyable arguments are read straight out of the ring, other ones are staged in a buffer first
+	// one thread at a time may poll a given ipc_signal, emit() may be called from any thread or process
+	template<class... Args>
+	class ipc_signal<void(Args...)> {
+	public:
+		// open the region called name (see shm_open), creating it if needed
+		// slots and slot_size are used by the process that creates it, the others take the stored ones
+		ipc_signal(char const *name, size_t slots = 1024, size_t slot_size = 256) {
+			slot_size = (slot_size + sizeof(details::ipc_slot) + 63) / 64 * 64;
+			slots = slots ? slots : 1;
+			size_t bytes = sizeof(details::ipc_header) + slots * slot_size;
+			bool creator = true;
+			int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+			if (fd < 0) {
+				creator = false;
+				fd = shm_open(name, O_RDWR, 0600);
+				if (fd < 0) return;
+			}
+			if (creator) {
+				if (ftruncate(fd, (off_t)bytes) != 0) {
+					close(fd);
+					return;
+				}
+			} else {
+				// the creator may not be done yet
+				struct stat st;
+				while (fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(details::ipc_header))
+					std::this_thread::yield();
+				bytes = (size_t)st.st_size;
+			}
+			void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd);
+			if (mem == MAP_FAILED) return;
+			auto *h = (details::ipc_header*)mem;
+			if (creator) {
+				h->fSlots = slots;
+				h->fSlotSize = slot_size;
+				h->fMagic.store(details::ipc_magic, std::memory_order_release);
+			} else {
+				while (h->fMagic.load(std::memory_order_acquire) != details::ipc_magic)
+					std::this_thread::yield();
+				if (sizeof(details::ipc_header) + h->fSlots * h->fSlotSize > bytes) {
+					munmap(mem, bytes);
+					return;
 				}
-
 			}
+			fHeader = h;
+			fMapped = bytes;
+			fCursor = h->fHead.load(std::memory_order_acquire);
+			if (!zero_copy) fStage.resize(h->fSlotSize);
 		}
-		
 
-		template<class = std::enable_if_t< !std::is_same<Return, void>::value, void>>
-		bool emit_and_get_last_result(Args... args,
-				std::conditional_t<std::is_same<Return, void>::value, int, Return> &last) const
-		{
-			auto const *end = &fConnectionBodies;
-			auto p = fConnectionBodies.fNext;
+		ipc_signal(ipc_signal const &) = delete;
+		ipc_signal &operator=(ipc_signal const &) = delete;
 
-			for (; p != end && !static_cast<connection_body_type*>(p)->fConnected; p = p->fNext) { }
-			if (p == end) return false;
+		~ipc_signal() {
+			if (fHeader) munmap(fHeader, fMapped);
+		}
 
-			for (;;)
-			{
-				connection_body_type &body = static_cast<connection_body_type &>(*p);
+		// remove the name, processes that have it open keep their mapping
+		static void unlink(char const *name) {
+			shm_unlink(name);
+		}
 
-				details::auto_lock<Return, Args...> auto_lock(body); //prevent unlink from list
-				auto tmp = body.Invoke(details::copy_forward<Args>(args)...);
-				p = p->fNext;     // get next
+		bool is_open() const { return fHeader != nullptr; }
 
-				for (; p != end && !static_cast<connection_body_type*>(p)->fConnected; p = p->fNext) {}
-				if (p == end) {
-					last = std::move(tmp);
-					return false;
-				}
+		// records this ipc_signal skipped because the ring went round before they were read
+		size_t lost() const { return fLost; }
 
-			}
+		// the slots run by poll() and wait() in this process
+		signal<void(Args...)> &local() { return fLocal; }
+
+		template<class Func>
+		connection connect(Func&& func) {
+			return fLocal.connect(std::forward<Func>(func));
 		}
 
-		template<class = 
-			std::enable_if_t< 
-			    std::is_convertible<Return, bool>::value
-		    >
-		>
-		bool emit_util_false(Args... args) const
-		{
-			auto *end = &fConnectionBodies;
-			for (auto p = fConnectionBodies.fNext; p != end; )
-			{
-				// down cast
-				connection_body_type &body = static_cast<connection_body_type &>(*p);
+		// returns false if the arguments don't fit in a slot
+		bool emit(details::copy_forward_type<Args>... args) {
+			if (!fHeader) return false;
+			size_t sizes[] = { 0, journal_traits<std::decay_t<Args> >::size(args)... };
+			size_t bytes = 0;
+			for (size_t n : sizes) bytes += n;
+			if (bytes > fHeader->fSlotSize - sizeof(details::ipc_slot)) return false;
 
-				if (body.fConnected) {
-					details::auto_lock<Return, Args...> auto_lock(body);  //prevent unlink from list
-																		  // impossible inline
-																		  // copy before you forward
-					bool v = body.Invoke(details::copy_forward<Args>(args)...);
-					if (v == false) return false;
-					p = p->fNext;
-				}
+			uint64_t pos = fHeader->fHead.fetch_add(1, std::memory_order_relaxed);
+			auto *slot = SlotOf(pos);
+			slot->fSeq.store(2 * pos + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			slot->fSize = (uint32_t)bytes;
+			char *out = (char*)(slot + 1);
+			size_t i = 0;
+			int dummy[] = { 0, (journal_traits<std::decay_t<Args> >::write(out, args), out += sizes[++i], 0)... };
+			(void)dummy;
+			slot->fSeq.store(2 * pos + 2, std::memory_order_release);
 
-			}
+			fHeader->fWake.fetch_add(1, std::memory_order_release);
+			if (fHeader->fWaiters.load(std::memory_order_seq_cst))
+				details::futex_wake_all(&fHeader->fWake);
 			return true;
 		}
 
-		template<class =
-			std::enable_if_t<
-			std::is_convertible<Return, bool>::value
-			>
-		>
-			bool emit_util_true(Args... args) const
-		{
-			auto *end = &fConnectionBodies;
-			for (auto p = fConnectionBodies.fNext; p != end; )
-			{
-				// down cast
-				connection_body_type &body = static_cast<connection_body_type &>(*p);
-
-				if (body.fConnected) {
-					details::auto_lock<Return, Args...> auto_lock(body);  //prevent unlink from list
-																		  // impossible inline
-																		  // copy before you forward
-					bool v = body.Invoke(details::copy_forward<Args>(args)...);
-					if (v == true) return false;
-					p = p->fNext;
+		// dispatch at most max records, returns the number dispatched
+		size_t poll(size_t max = size_t(-1)) {
+			if (!fHeader) return 0;
+			size_t n = 0;
+			while (n < max) {
+				uint64_t head = fHeader->fHead.load(std::memory_order_acquire);
+				if (fCursor == head) break;
+				if (head - fCursor > fHeader->fSlots) {
+					// the ring went round
+					fLost += (size_t)(head - fHeader->fSlots - fCursor);
+					fCursor = head - fHeader->fSlots;
 				}
+				int r = TryDispatch(fCursor);
+				if (r == 0) break; // still being written
+				++fCursor;
+				if (r > 0) ++n; else ++fLost;
+			}
+			return n;
+		}
 
+		// wait until there is something to dispatch or timeout passed, then poll()
+		size_t wait(std::chrono::nanoseconds timeout, size_t max = size_t(-1)) {
+			if (!fHeader) return 0;
+			// a short spin first, so a busy producer doesn't pay a wake per record
+			for (int i = 0; i < 1000 && fHeader->fHead.load(std::memory_order_acquire) == fCursor; ++i)
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			uint32_t word = fHeader->fWake.load(std::memory_order_acquire);
+			if (fHeader->fHead.load(std::memory_order_acquire) == fCursor) {
+				fHeader->fWaiters.fetch_add(1, std::memory_order_seq_cst);
+				if (fHeader->fHead.load(std::memory_order_seq_cst) == fCursor)
+					details::futex_wait(&fHeader->fWake, word, timeout);
+				fHeader->fWaiters.fetch_sub(1, std::memory_order_relaxed);
 			}
-			return true;
+			return poll(max);
 		}
 
+		// true when every argument is trivially copyable, the records are then read straight out of the ring
+		static const bool zero_copy =
+			details::all_of<std::is_trivially_copyable<std::decay_t<Args> >::value...>::value;
 
-		template<class ResultHanler, class = decltype(std::declval<ResultHanler&&>()(std::declval<Return>())) >
-		void operator()(Args... args,
-				ResultHanler&& handler) const
-		{
-			auto *end = &fConnectionBodies;
-			for (auto p = fConnectionBodies.fNext; p != end; )
-			{
-				// down cast
-				connection_body_type &body = static_cast<connection_body_type &>(*p);
+	private:
+		using values_type = std::tuple<std::decay_t<Args>...>;
 
-				if (body.fConnected) {
-					details::auto_lock<Return, Args...> auto_lock(body);  //prevent unlink from list
-																		  // impossible inline
-					handler(body.Invoke(details::copy_forward<Args>(args)...));
-					p = p->fNext;
-				}
+		details::ipc_header *fHeader = nullptr;
+		size_t fMapped = 0;
+		uint64_t fCursor = 0;
+		size_t fLost = 0;
+		std::vector<char> fStage;
+		signal<void(Args...)> fLocal;
 
-			}
+		details::ipc_slot *SlotOf(uint64_t pos) {
+			char *first = (char*)fHeader + sizeof(details::ipc_header);
+			return (details::ipc_slot*)(first + (pos % fHeader->fSlots) * fHeader->fSlotSize);
 		}
 
-		result_range<Signature> emit_and_get_range(Args... args) const
-		{
-			auto p = fConnectionBodies.fNext;
-			auto end = &fConnectionBodies;
-			for (; p != end && !static_cast<connection_body_type*>(p)->fConnected; p = p->fNext) {}
-
-			// move if possible
-			return result_range<Signature>(p, end, std::forward<Args>(args)...);
+		// 1 dispatched, 0 not written yet, -1 overwritten
+		int TryDispatch(uint64_t pos) {
+			auto *slot = SlotOf(pos);
+			uint64_t seq = slot->fSeq.load(std::memory_order_acquire);
+			if (seq < 2 * pos + 2) return 0;
+			if (seq > 2 * pos + 2) return -1;
+			char const *in = (char const*)(slot + 1);
+			if (!zero_copy) {
+				// copy the record out and check it before decoding, a torn length could lead anywhere
+				memcpy(fStage.data(), in, fStage.size() - sizeof(details::ipc_slot));
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot->fSeq.load(std::memory_order_relaxed) != seq) return -1;
+				in = fStage.data();
+			}
+			// braced init reads the arguments in order
+			values_type values{ journal_traits<std::decay_t<Args> >::read(in)... };
+			(void)in;
+			if (zero_copy) {
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot->fSeq.load(std::memory_order_relaxed) != seq) return -1;
+			}
+			Dispatch(values, std::index_sequence_for<Args...>());
+			return 1;
 		}
 
+		template<size_t... I>
+		void Dispatch(values_type &values, std::index_sequence<I...>) {
+			fLocal(std::forward<Args>(std::get<I>(values))...);
+		}
 	};
+}
+#endif
 
-	template<class Signature>
-	struct get_signal_impl;
+// replace the global operator new, so the accounting sees every allocation
+// define TISS_DEFINE_ALLOC_HOOKS in exactly one translation unit, with TISS_ALLOC_ACCOUNTING
+#if defined(TISS_DEFINE_ALLOC_HOOKS) && TISS_ALLOC_ACCOUNTING
+#include <new>
 
-	template<class Return, class... Args>
-	struct get_signal_impl<Return(Args...)> {
-		using type = signal_impl<Return, Args...>;
-	};
+namespace tiss {
+	namespace details {
+		static const bool tiss_alloc_hooks_installed = (global_alloc_hooks() = true);
+	}
+}
 
-	template<class Signature>
-	class signal : public get_signal_impl<Signature>::type
-	{
-	public:
-		using base_type = typename get_signal_impl<Signature>::type;
-		signal() : base_type() { }
-		signal(signal&& r) : base_type(std::move((base_type&&)r)) { }
-		signal& operator=(signal&& r) { (base_type&)(*this) = std::move(r); }
-	};
+void *operator new(size_t bytes)
+{
+	tiss::details::note_alloc(bytes);
+	if (void *p = malloc(bytes ? bytes : 1)) return p;
+	throw std::bad_alloc();
+}
 
+void *operator new[](size_t bytes)
+{
+	return ::operator new(bytes);
 }
 
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+#endif
+
 #endif // TISS_H